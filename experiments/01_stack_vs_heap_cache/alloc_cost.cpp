@@ -0,0 +1,264 @@
+#include <alloca.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// main.cpp in this directory measures ACCESS cost and says so.
+// This program measures the other half: ALLOCATION cost.
+//
+// Per-allocation latency (ns) for:
+//
+//   stack    fixed-size array in a fresh stack frame
+//   alloca   runtime-sized stack allocation
+//   new[]    new int[N] (glibc malloc underneath)
+//   vector   std::vector<int> grown by push_back, no reserve()
+//   pmr      std::pmr::monotonic_buffer_resource over a pre-touched buffer
+//
+// across sizes from 64 B to 64 MB. The interesting boundary is glibc's
+// mmap threshold. By default it is 128 KB but DYNAMIC: the first free of
+// an mmapped block raises it to that block's size (up to 32 MB), so
+// only the first large new[] would be an mmap(). main() pins it at
+// 128 KB with mallopt (which also turns the adjustment off): above it,
+// every new[] is an mmap() + munmap() pair plus page faults on touch.
+//
+// THEORY:
+// - stack / alloca / pmr are pointer bumps; cost is flat in size
+//   ...until pages are touched for the first time.
+// - new[] below the threshold is a free-list pop; above it, a syscall.
+// - vector growth pays log2(N) reallocations + copies.
+//
+// Each sample writes one byte so nothing is elided. Pass --touch to
+// also write one byte per page (what a real caller eventually pays).
+// ------------------------------------------------------------
+
+constexpr size_t MIN_SIZE = 64;
+constexpr size_t MAX_SIZE = 64ull << 20;
+
+// Large frames need a large stack: everything runs on a thread
+// whose stack comfortably holds the 64 MB frame twice.
+constexpr size_t THREAD_STACK = 256ull << 20;
+
+volatile uint64_t sink = 0;
+
+static bool g_touch = false;
+static long g_page = 4096;
+
+static void touch_pages(volatile char* p, size_t bytes) {
+    p[0] = 1;
+    if (!g_touch) return;
+    for (size_t off = 0; off < bytes; off += (size_t)g_page) p[off] = 1;
+    p[bytes - 1] = 1;
+}
+
+// Fewer samples for huge sizes so the whole sweep stays in seconds.
+static size_t samples_for(size_t bytes) {
+    const size_t budget = (size_t)1 << 28;
+    size_t n = budget / bytes;
+    if (n < 32) n = 32;
+    if (n > 10'000) n = 10'000;
+    return n;
+}
+
+template <typename F>
+static uint64_t time_ns(F&& f) {
+    const auto t0 = Clock::now();
+    f();
+    const auto t1 = Clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+}
+
+// ------------------------------------------------------------
+// Stack frame: compile-time size, one instantiation per sweep point.
+// noinline so the frame is really set up and torn down per call.
+// ------------------------------------------------------------
+template <size_t N>
+__attribute__((noinline)) uint64_t stack_frame() {
+    char buf[N];
+    volatile char* p = buf;
+    touch_pages(p, N);
+    return (uint64_t)p[0];
+}
+
+__attribute__((noinline)) static uint64_t alloca_frame(size_t n) {
+    volatile char* p = static_cast<char*>(alloca(n));
+    touch_pages(p, n);
+    return (uint64_t)p[0];
+}
+
+template <size_t N>
+static void run_stack() {
+    std::vector<uint64_t> s;
+    const size_t n = samples_for(N);
+    s.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        s.push_back(time_ns([] { sink = sink + stack_frame<N>(); }));
+    }
+    lat::print_table_row("stack  " + lat::format_bytes(N), lat::compute_stats(s));
+}
+
+template <size_t... Sizes>
+static void run_stack_sweep(std::index_sequence<Sizes...>) {
+    (run_stack<(MIN_SIZE << (2 * Sizes))>(), ...);
+}
+
+static void run_alloca(size_t bytes) {
+    std::vector<uint64_t> s;
+    const size_t n = samples_for(bytes);
+    s.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        s.push_back(time_ns([&] { sink = sink + alloca_frame(bytes); }));
+    }
+    lat::print_table_row("alloca " + lat::format_bytes(bytes), lat::compute_stats(s));
+}
+
+static void run_new(size_t bytes) {
+    std::vector<uint64_t> s;
+    const size_t n = samples_for(bytes);
+    const size_t count = bytes / sizeof(int);
+    s.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        int* p = nullptr;
+        s.push_back(time_ns([&] {
+            p = new int[count];
+            touch_pages(reinterpret_cast<volatile char*>(p), bytes);
+        }));
+        sink = sink + (uint64_t)p[0];
+        delete[] p; // NOT timed; munmap for large blocks lands here
+    }
+    lat::print_table_row("new[]  " + lat::format_bytes(bytes), lat::compute_stats(s));
+}
+
+static void run_vector(size_t bytes) {
+    std::vector<uint64_t> s;
+    const size_t n = samples_for(bytes);
+    const size_t count = bytes / sizeof(int);
+    s.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        std::vector<int> v;
+        // push_back writes every element, so --touch is implied here.
+        s.push_back(time_ns([&] {
+            for (size_t k = 0; k < count; k++) v.push_back((int)k);
+        }));
+        sink = sink + (uint64_t)v.back();
+    }
+    lat::print_table_row("vector " + lat::format_bytes(bytes), lat::compute_stats(s));
+}
+
+static void run_pmr(size_t bytes, void* arena, size_t arena_bytes) {
+    std::vector<uint64_t> s;
+    const size_t n = samples_for(bytes);
+    s.reserve(n);
+
+    // Upstream is null_memory_resource: any overflow throws instead of
+    // silently falling back to the heap and polluting the numbers.
+    std::pmr::monotonic_buffer_resource res(arena, arena_bytes,
+                                            std::pmr::null_memory_resource());
+    for (size_t i = 0; i < n; i++) {
+        void* p = nullptr;
+        s.push_back(time_ns([&] {
+            p = res.allocate(bytes, alignof(std::max_align_t));
+            touch_pages(static_cast<volatile char*>(p), bytes);
+        }));
+        sink = sink + (uint64_t)static_cast<volatile char*>(p)[0];
+        res.release(); // NOT timed; rewinds to the start of the arena
+    }
+    lat::print_table_row("pmr    " + lat::format_bytes(bytes), lat::compute_stats(s));
+}
+
+static std::vector<size_t> sweep_sizes() {
+    std::vector<size_t> sizes;
+    for (size_t b = MIN_SIZE; b <= MAX_SIZE; b <<= 2) sizes.push_back(b);
+    return sizes;
+}
+
+static void* run_all(void*) {
+    const auto sizes = sweep_sizes();
+
+    // 64B << (2*10) == 64MB: eleven stack-frame instantiations.
+    std::printf("\n-- stack frame (fixed size, fresh frame per call) --\n");
+    lat::print_table_header("case");
+    run_stack_sweep(std::make_index_sequence<11>{});
+
+    std::printf("\n-- alloca (runtime size) --\n");
+    lat::print_table_header("case");
+    for (size_t b : sizes) run_alloca(b);
+
+    std::printf("\n-- new int[N] (crosses glibc mmap threshold) --\n");
+    lat::print_table_header("case");
+    for (size_t b : sizes) run_new(b);
+
+    std::printf("\n-- std::vector<int> push_back growth, no reserve --\n");
+    lat::print_table_header("case");
+    for (size_t b : sizes) run_vector(b);
+
+    // Arena is allocated and pre-touched once, outside every measurement.
+    const size_t arena_bytes = MAX_SIZE + 4096;
+    void* arena = std::aligned_alloc(4096, arena_bytes);
+    std::memset(arena, 0, arena_bytes);
+
+    std::printf("\n-- pmr::monotonic_buffer_resource (pre-touched arena) --\n");
+    lat::print_table_header("case");
+    for (size_t b : sizes) run_pmr(b, arena, arena_bytes);
+
+    std::free(arena);
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--touch") g_touch = true;
+    }
+    g_page = sysconf(_SC_PAGESIZE);
+#if defined(__GLIBC__)
+    // Fixed threshold: every new[] >= 128 KB is an mmap(), not just the first.
+    const bool fixed_threshold = mallopt(M_MMAP_THRESHOLD, 128 * 1024) == 1;
+#else
+    const bool fixed_threshold = false;
+#endif
+
+    std::printf("=== Allocation cost (ns per allocation) ===\n");
+    std::printf("mode: %s\n", g_touch ? "allocate + touch every page"
+                                      : "allocate + touch first byte only");
+    std::printf("malloc mmap threshold: %s\n", fixed_threshold ? "fixed at 128 KB" : "allocator default");
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK);
+
+    pthread_t th;
+    if (pthread_create(&th, &attr, run_all, nullptr) != 0) {
+        std::perror("pthread_create");
+        return 1;
+    }
+    pthread_join(th, nullptr);
+    pthread_attr_destroy(&attr);
+
+    std::printf("\nNOTE:\n");
+    std::printf("Stack, alloca and pmr are flat: a pointer bump.\n");
+    std::printf("new[] jumps where glibc switches to mmap(); with --touch\n");
+    std::printf("every page of every fresh block is a page fault.\n");
+    std::printf("The first stack call at a new depth pays faults once;\n");
+    std::printf("after that the pages stay mapped (see p99.9 / max).\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include <alloca.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// main.cpp uses ARRAY_SIZE = 1024 ints, which always fits in L1,
+// so stack and heap are identical by construction.
+//
+// This program sweeps the working-set size from 1 KB to well past
+// the last-level cache and reports ns per access with percentiles,
+// for four kinds of backing memory:
+//
+//   stack     alloca() on a thread with a very large stack
+//   heap      std::aligned_alloc
+//   mmap      anonymous mmap, THP disabled (4 KB pages)
+//   hugepage  MAP_HUGETLB if reserved, else mmap + MADV_HUGEPAGE
+//
+// and two access patterns, both as a dependent pointer chase so the
+// CPU cannot overlap loads:
+//
+//   seq       next cache line each step (prefetcher-friendly)
+//   rand      random cyclic permutation of cache lines
+//
+// THEORY:
+// - Each plateau is a cache level: L1, L2, LLC, DRAM.
+// - seq stays flat far longer because of hardware prefetch.
+// - rand past the LLC pays DRAM latency PLUS TLB misses; huge pages
+//   remove most of the TLB part, which is the hugepage vs mmap gap.
+// - Backing type only matters through page size / TLB reach,
+//   never through "stack vs heap".
+//
+// One sample = one block of CHASE_BLOCK dependent loads;
+// the reported value is ns per access within that block.
+// ------------------------------------------------------------
+
+constexpr size_t LINE        = 64;
+constexpr size_t MIN_BYTES   = 1024;
+constexpr size_t HUGE_PAGE   = 2ull << 20;
+constexpr int    CHASE_BLOCK = 256;
+constexpr int    SAMPLES     = 10'000;
+
+volatile uintptr_t sink = 0;
+
+enum class Backing { Stack, Heap, Mmap, Hugepage };
+
+static const char* backing_name(Backing b) {
+    switch (b) {
+        case Backing::Stack:    return "stack";
+        case Backing::Heap:     return "heap";
+        case Backing::Mmap:     return "mmap";
+        case Backing::Hugepage: return "hugepage";
+    }
+    return "?";
+}
+
+// ------------------------------------------------------------
+// Pointer chase over the first `bytes` of `buf`.
+// Each 64-byte line holds a pointer to the next line in the cycle.
+// ------------------------------------------------------------
+static void build_chain(char* buf, size_t bytes, bool random, std::mt19937_64& rng) {
+    const size_t lines = bytes / LINE;
+    std::vector<size_t> order(lines);
+    std::iota(order.begin(), order.end(), 0);
+    if (random) std::shuffle(order.begin() + 1, order.end(), rng);
+
+    for (size_t i = 0; i < lines; i++) {
+        char* cur  = buf + order[i] * LINE;
+        char* next = buf + order[(i + 1) % lines] * LINE;
+        std::memcpy(cur, &next, sizeof(next));
+    }
+}
+
+__attribute__((noinline)) static void* chase(void* p, int steps) {
+    for (int i = 0; i < steps; i++) p = *static_cast<void**>(p);
+    return p;
+}
+
+// Samples are ns/access scaled by 100 so two decimals survive
+// the integer percentile machinery; printed back as a float.
+static void run_point(char* buf, size_t bytes, bool random, Backing b, std::mt19937_64& rng) {
+    build_chain(buf, bytes, random, rng);
+
+    // Warmup: walk the whole working set once (capped) so the
+    // caches and TLB hold what they are going to hold.
+    void* p = buf;
+    const size_t warm = std::min<size_t>(bytes / LINE, 4'000'000);
+    p = chase(p, (int)warm);
+
+    std::vector<uint64_t> samples;
+    samples.reserve(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++) {
+        const auto t0 = Clock::now();
+        p = chase(p, CHASE_BLOCK);
+        const auto t1 = Clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        samples.push_back((uint64_t)ns * 100 / CHASE_BLOCK);
+    }
+    sink = sink + (uintptr_t)p;
+
+    const lat::Stats s = lat::compute_stats(samples);
+    std::printf("%-9s %-5s %10s %9.2f %9.2f %9.2f %9.2f %9.2f %10.2f\n",
+                backing_name(b), random ? "rand" : "seq",
+                lat::format_bytes(bytes).c_str(),
+                s.avg / 100.0, s.p50 / 100.0, s.p90 / 100.0,
+                s.p99 / 100.0, s.p999 / 100.0, s.max / 100.0);
+}
+
+static void print_header() {
+    std::printf("%-9s %-5s %10s %9s %9s %9s %9s %9s %10s\n",
+                "backing", "order", "size", "avg", "p50", "p90", "p99", "p99.9", "max");
+}
+
+static void sweep(char* buf, size_t max_bytes, Backing b, size_t step) {
+    std::mt19937_64 rng(42);
+    // Pre-touch the full region once, outside every measurement.
+    std::memset(buf, 0, max_bytes);
+    for (int r = 0; r < 2; r++) {
+        for (size_t bytes = MIN_BYTES; bytes <= max_bytes; bytes *= step) {
+            run_point(buf, bytes, r == 1, b, rng);
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// Backings
+// ------------------------------------------------------------
+
+struct StackArgs {
+    size_t max_bytes;
+    size_t step;
+};
+
+static void* stack_thread(void* arg) {
+    const auto* a = static_cast<StackArgs*>(arg);
+    // Line-align the alloca'd region like the other backings.
+    char* raw = static_cast<char*>(alloca(a->max_bytes + LINE));
+    char* buf = reinterpret_cast<char*>(((uintptr_t)raw + LINE - 1) & ~(uintptr_t)(LINE - 1));
+    sweep(buf, a->max_bytes, Backing::Stack, a->step);
+    sink = sink + (uintptr_t)buf[0];
+    return nullptr;
+}
+
+static void run_stack(size_t max_bytes, size_t step) {
+    StackArgs args{max_bytes, step};
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, max_bytes + (16ull << 20));
+    pthread_t th;
+    if (pthread_create(&th, &attr, stack_thread, &args) != 0) {
+        std::perror("pthread_create (large stack)");
+    } else {
+        pthread_join(th, nullptr);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static void run_heap(size_t max_bytes, size_t step) {
+    char* buf = static_cast<char*>(std::aligned_alloc(LINE, max_bytes));
+    if (!buf) { std::perror("aligned_alloc"); return; }
+    sweep(buf, max_bytes, Backing::Heap, step);
+    std::free(buf);
+}
+
+static void run_mmap(size_t max_bytes, size_t step) {
+    void* m = mmap(nullptr, max_bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) { std::perror("mmap"); return; }
+    // Keep this the 4 KB-page reference point even if THP is "always".
+    madvise(m, max_bytes, MADV_NOHUGEPAGE);
+    sweep(static_cast<char*>(m), max_bytes, Backing::Mmap, step);
+    munmap(m, max_bytes);
+}
+
+static void run_hugepage(size_t max_bytes, size_t step) {
+    const size_t len = (max_bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+
+    // Preferred: explicitly reserved hugetlbfs pages (vm.nr_hugepages).
+    void* m = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (m != MAP_FAILED) {
+        std::printf("# hugepage: MAP_HUGETLB\n");
+        sweep(static_cast<char*>(m), max_bytes, Backing::Hugepage, step);
+        munmap(m, len);
+        return;
+    }
+
+    // Fallback: transparent huge pages on a 2 MB-aligned region.
+    const size_t over = len + HUGE_PAGE;
+    void* raw = mmap(nullptr, over, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) { std::perror("mmap (thp)"); return; }
+    char* aligned = reinterpret_cast<char*>(((uintptr_t)raw + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+    madvise(aligned, len, MADV_HUGEPAGE);
+    std::printf("# hugepage: MAP_HUGETLB unavailable, using MADV_HUGEPAGE (THP, best effort)\n");
+    sweep(aligned, max_bytes, Backing::Hugepage, step);
+    munmap(raw, over);
+}
+
+// ------------------------------------------------------------
+
+static size_t default_max_bytes() {
+    // 4x the LLC, clamped to [64 MB, 512 MB]: far enough past it to
+    // see DRAM + TLB, small enough for a laptop. Override with --max-mb.
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc <= 0) llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    size_t want = llc > 0 ? (size_t)llc * 4 : (size_t)64 << 20;
+    if (want < (64ull << 20))  want = 64ull << 20;
+    if (want > (512ull << 20)) want = 512ull << 20;
+
+    size_t b = MIN_BYTES;
+    while (b < want) b *= 2;
+    return b;
+}
+
+int main(int argc, char** argv) {
+    size_t max_bytes = default_max_bytes();
+    size_t step = 4;
+    std::string only;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--max-mb=", 0) == 0) max_bytes = std::stoull(a.substr(9)) << 20;
+        else if (a == "--fine") step = 2;
+        else only = a; // stack | heap | mmap | hugepage
+    }
+
+    std::printf("=== Working-set sweep (ns per dependent access) ===\n");
+    std::printf("L1d=%ld L2=%ld L3=%ld bytes; sweep %s .. %s, x%zu\n",
+                sysconf(_SC_LEVEL1_DCACHE_SIZE), sysconf(_SC_LEVEL2_CACHE_SIZE),
+                sysconf(_SC_LEVEL3_CACHE_SIZE),
+                lat::format_bytes(MIN_BYTES).c_str(),
+                lat::format_bytes(max_bytes).c_str(), step);
+    print_header();
+
+    if (only.empty() || only == "stack")    run_stack(max_bytes, step);
+    if (only.empty() || only == "heap")     run_heap(max_bytes, step);
+    if (only.empty() || only == "mmap")     run_mmap(max_bytes, step);
+    if (only.empty() || only == "hugepage") run_hugepage(max_bytes, step);
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
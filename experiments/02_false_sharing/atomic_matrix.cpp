@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// Atomic operation latency matrix
+// ------------------------------------------------------------
+// main.cpp shows that two threads on one cache line are slow.
+// This program asks: how slow is EACH atomic operation, in EACH
+// memory order, at EACH contention level?
+//
+//   ops:        load, store, exchange, CAS, fetch_add, fetch_or, CAS-128
+//   orders:     relaxed, acq/rel, seq_cst
+//               (load: acquire, store: release, RMW: acq_rel)
+//   contention: 1 thread (uncontended) .. N threads on the SAME line
+//
+// One sample = a block of OPS_PER_SAMPLE back-to-back operations on
+// the measuring thread; reported as ns per operation, percentiles.
+// The other N-1 threads run the same operation in a loop, except for
+// load: loads alone only share the line read-only, so one of them
+// stores (relaxed) instead and the loads see it change.
+//
+// THEORY (x86):
+// - loads and stores are plain MOVs in relaxed/acquire/release;
+//   a seq_cst STORE becomes XCHG (a full barrier).
+// - every RMW is LOCK-prefixed: the memory order barely matters,
+//   the contention level dominates (cache line ping-pong).
+// - on ARM the orders DO differ (ldar/stlr, dmb); run it there too.
+// - CAS under contention also FAILS; the fail % column shows it.
+// ------------------------------------------------------------
+
+constexpr int OPS_PER_SAMPLE = 64;
+constexpr int SAMPLES        = 20'000;
+
+volatile uint64_t sink = 0;
+
+enum class Op { Load, Store, Exchange, Cas, FetchAdd, FetchOr, Cas128 };
+enum class Order { Relaxed, AcqRel, SeqCst };
+
+static const char* op_name(Op op) {
+    switch (op) {
+        case Op::Load:     return "load";
+        case Op::Store:    return "store";
+        case Op::Exchange: return "exchange";
+        case Op::Cas:      return "cas";
+        case Op::FetchAdd: return "fetch_add";
+        case Op::FetchOr:  return "fetch_or";
+        case Op::Cas128:   return "cas128";
+    }
+    return "?";
+}
+
+static const char* order_name(Order o) {
+    switch (o) {
+        case Order::Relaxed: return "relaxed";
+        case Order::AcqRel:  return "acq/rel";
+        case Order::SeqCst:  return "seq_cst";
+    }
+    return "?";
+}
+
+template <Order O> constexpr std::memory_order load_order() {
+    return O == Order::Relaxed ? std::memory_order_relaxed
+         : O == Order::AcqRel  ? std::memory_order_acquire
+                               : std::memory_order_seq_cst;
+}
+template <Order O> constexpr std::memory_order store_order() {
+    return O == Order::Relaxed ? std::memory_order_relaxed
+         : O == Order::AcqRel  ? std::memory_order_release
+                               : std::memory_order_seq_cst;
+}
+template <Order O> constexpr std::memory_order rmw_order() {
+    return O == Order::Relaxed ? std::memory_order_relaxed
+         : O == Order::AcqRel  ? std::memory_order_acq_rel
+                               : std::memory_order_seq_cst;
+}
+
+__extension__ typedef unsigned __int128 u128;
+
+// The contended cache line. 128-bit word first for 16-byte alignment.
+struct alignas(64) SharedLine {
+    u128                   wide = 0;
+    std::atomic<uint64_t>  word{0};
+};
+
+struct Counters {
+    uint64_t cas_fail = 0;
+    uint64_t cas_total = 0;
+    u128     wide_seen = 0; // cas128: the value our last CAS observed
+};
+
+// One block of OPS_PER_SAMPLE operations. noinline keeps the loop
+// body identical whether the measuring or a background thread runs it.
+template <Op OP, Order O>
+__attribute__((noinline)) static void op_block(SharedLine& l, Counters& c, uint64_t& acc) {
+    for (int i = 0; i < OPS_PER_SAMPLE; i++) {
+        if constexpr (OP == Op::Load) {
+            acc += l.word.load(load_order<O>());
+        } else if constexpr (OP == Op::Store) {
+            l.word.store(acc + (uint64_t)i, store_order<O>());
+        } else if constexpr (OP == Op::Exchange) {
+            acc += l.word.exchange(acc + (uint64_t)i, rmw_order<O>());
+        } else if constexpr (OP == Op::Cas) {
+            uint64_t expected = l.word.load(std::memory_order_relaxed);
+            const bool ok = l.word.compare_exchange_strong(expected, expected + 1,
+                                                           rmw_order<O>(),
+                                                           std::memory_order_relaxed);
+            c.cas_fail += ok ? 0 : 1;
+            c.cas_total++;
+        } else if constexpr (OP == Op::FetchAdd) {
+            acc += l.word.fetch_add(1, rmw_order<O>());
+        } else if constexpr (OP == Op::FetchOr) {
+            acc += l.word.fetch_or((uint64_t)1 << (i & 63), rmw_order<O>());
+        } else {
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+            // LOCK CMPXCHG16B: always a full barrier, so O has no effect.
+            // No plain (racy) 16-byte read: the expected value is what
+            // the previous CAS returned, so a failure refreshes it.
+            const u128 prev = __sync_val_compare_and_swap(&l.wide, c.wide_seen, c.wide_seen + 1);
+            const bool ok = prev == c.wide_seen;
+            c.wide_seen = ok ? prev + 1 : prev;
+            c.cas_fail += ok ? 0 : 1;
+            c.cas_total++;
+#else
+            (void)l;
+            (void)c;
+#endif
+        }
+    }
+}
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+template <Op OP, Order O>
+static void run_cell(int threads) {
+    SharedLine line;
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::atomic<int>  ready{0};
+
+    // Per-thread results, summed into sink after the join.
+    std::vector<uint64_t> bg_acc(threads, 0);
+    std::vector<std::thread> bg;
+    for (int t = 1; t < threads; t++) {
+        bg.emplace_back([&, t] {
+            pin_to(t);
+            Counters c;
+            uint64_t acc = 0;
+            ready.fetch_add(1);
+            while (!start.load(std::memory_order_acquire)) {}
+            if (OP == Op::Load && t == 1) {
+                while (!stop.load(std::memory_order_relaxed)) op_block<Op::Store, Order::Relaxed>(line, c, acc);
+            } else {
+                while (!stop.load(std::memory_order_relaxed)) op_block<OP, O>(line, c, acc);
+            }
+            bg_acc[t] = acc;
+        });
+    }
+
+    pin_to(0);
+    while (ready.load() != threads - 1) {}
+    start.store(true, std::memory_order_release);
+
+    Counters c;
+    uint64_t acc = 0;
+    for (int i = 0; i < 1000; i++) op_block<OP, O>(line, c, acc); // warmup
+    c.cas_fail = c.cas_total = 0;
+
+    std::vector<uint64_t> samples;
+    samples.reserve(SAMPLES);
+    for (int s = 0; s < SAMPLES; s++) {
+        const auto t0 = Clock::now();
+        op_block<OP, O>(line, c, acc);
+        const auto t1 = Clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        samples.push_back((uint64_t)ns * 100 / OPS_PER_SAMPLE);
+    }
+
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& th : bg) th.join();
+    for (uint64_t a : bg_acc) acc += a;
+    sink = sink + acc;
+
+    const lat::Stats s = lat::compute_stats(samples);
+    char fail[16] = "-";
+    if (c.cas_total > 0) {
+        std::snprintf(fail, sizeof(fail), "%.1f%%", 100.0 * (double)c.cas_fail / (double)c.cas_total);
+    }
+    std::printf("%-10s %-8s %7d %8.2f %8.2f %8.2f %8.2f %9.2f %8s\n",
+                op_name(OP), order_name(O), threads,
+                s.p50 / 100.0, s.p90 / 100.0, s.p99 / 100.0,
+                s.p999 / 100.0, s.max / 100.0, fail);
+}
+
+template <Op OP>
+static void run_op(const std::vector<int>& levels) {
+    for (int t : levels) {
+        run_cell<OP, Order::Relaxed>(t);
+        run_cell<OP, Order::AcqRel>(t);
+        run_cell<OP, Order::SeqCst>(t);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int ncpu = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    int max_threads = ncpu;
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--max-threads=", 0) == 0) max_threads = std::max(1, std::atoi(a.c_str() + 14));
+        else only = a;
+    }
+
+    // 1, 2, 4, ... and max_threads itself.
+    std::vector<int> levels;
+    for (int t = 1; t < max_threads; t *= 2) levels.push_back(t);
+    levels.push_back(max_threads);
+
+    std::printf("Atomic latency matrix (ns per op), %d CPUs online\n", ncpu);
+    if (max_threads > ncpu) {
+        std::printf("NOTE: %d threads > %d CPUs: contended rows include time-slicing.\n",
+                    max_threads, ncpu);
+    }
+#if !defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+    std::printf("NOTE: no inline 16-byte CAS (build with -mcx16 / -march=native); cas128 rows are empty.\n");
+#endif
+    std::printf("%-10s %-8s %7s %8s %8s %8s %8s %9s %8s\n",
+                "op", "order", "threads", "p50", "p90", "p99", "p99.9", "max", "fail");
+
+    auto want = [&](Op op) { return only.empty() || only == op_name(op); };
+    if (want(Op::Load))     run_op<Op::Load>(levels);
+    if (want(Op::Store))    run_op<Op::Store>(levels);
+    if (want(Op::Exchange)) run_op<Op::Exchange>(levels);
+    if (want(Op::Cas))      run_op<Op::Cas>(levels);
+    if (want(Op::FetchAdd)) run_op<Op::FetchAdd>(levels);
+    if (want(Op::FetchOr))  run_op<Op::FetchOr>(levels);
+    if (want(Op::Cas128))   run_op<Op::Cas128>(levels);
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  Compare rows with the same op and threads: that is the cost of the order.\n");
+    std::printf("  Compare rows with the same op and order: that is the cost of contention.\n");
+    std::printf("  On x86 expect the second to dwarf the first, except for seq_cst stores.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// Caches are set-associative: an address maps to ONE set, and a set
+// holds only `ways` lines. Addresses spaced by a power-of-two stride
+// that is a multiple of (sets * line) all land in the SAME set.
+//
+// With N such addresses and N > ways, every access evicts another
+// one: a working set of a few hundred bytes behaves like DRAM.
+//
+// Part 1 — set conflicts
+//   Chase N addresses spaced by:
+//     4 KiB              L1 way size (64 sets x 64 B on most x86)
+//     L2 way size        sets(L2) x line, from sysconf
+//     LLC way size       nominal; real LLCs hash addresses over slices
+//   versus the same strides padded by one cache line (+64 B), which
+//   walks the addresses across different sets.
+//
+// Part 2 — 4K aliasing (store-to-load)
+//   The load unit compares only address bits [11:0] against pending
+//   stores. A load whose low 12 bits match an older in-flight store
+//   to a DIFFERENT address is held back as if it depended on it.
+//   Loop: store dst[i]; load src[i]; with src - dst == 4096 (aliasing)
+//   versus 4096 + 64 (no aliasing).
+//
+// THEORY:
+// - Padded strides stay flat (L1 latency) until N * line spills L1.
+// - Power-of-two strides cliff at N == ways of the level in question.
+// - L2 / LLC sets are physically indexed: with 4 KB pages the physical
+//   placement is random, so we ask for THP to keep the pattern intact.
+// ------------------------------------------------------------
+
+constexpr size_t LINE        = 64;
+constexpr size_t HUGE_PAGE   = 2ull << 20;
+constexpr int    CHASE_BLOCK = 256;
+constexpr int    SAMPLES     = 5'000;
+constexpr int    MAX_N       = 48;
+
+volatile uintptr_t sink = 0;
+
+struct Region {
+    char*  base = nullptr;
+    void*  raw = nullptr;
+    size_t raw_len = 0;
+};
+
+// 2 MB-aligned, THP-advised, pre-touched.
+static Region map_region(size_t len) {
+    Region r;
+    r.raw_len = len + HUGE_PAGE;
+    r.raw = mmap(nullptr, r.raw_len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (r.raw == MAP_FAILED) {
+        std::perror("mmap");
+        r.raw = nullptr;
+        return r;
+    }
+    r.base = reinterpret_cast<char*>(((uintptr_t)r.raw + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+    madvise(r.base, len, MADV_HUGEPAGE);
+    std::memset(r.base, 0, len);
+    return r;
+}
+
+static void unmap_region(Region& r) {
+    if (r.raw) munmap(r.raw, r.raw_len);
+    r = Region{};
+}
+
+__attribute__((noinline)) static void* chase(void* p, int steps) {
+    for (int i = 0; i < steps; i++) p = *static_cast<void**>(p);
+    return p;
+}
+
+// Samples are ns/access x100 (two decimals through integer percentiles).
+static lat::Stats measure_chase(char* base, size_t stride, int n) {
+    for (int i = 0; i < n; i++) {
+        char* cur  = base + (size_t)i * stride;
+        char* next = base + (size_t)((i + 1) % n) * stride;
+        std::memcpy(cur, &next, sizeof(next));
+    }
+
+    void* p = chase(base, 10'000);
+
+    std::vector<uint64_t> samples;
+    samples.reserve(SAMPLES);
+    for (int s = 0; s < SAMPLES; s++) {
+        const auto t0 = Clock::now();
+        p = chase(p, CHASE_BLOCK);
+        const auto t1 = Clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        samples.push_back((uint64_t)ns * 100 / CHASE_BLOCK);
+    }
+    sink = sink + (uintptr_t)p;
+    return lat::compute_stats(samples);
+}
+
+static void print_header() {
+    std::printf("%-22s %4s %9s %9s %9s %9s %9s\n",
+                "stride", "N", "p50", "p90", "p99", "p99.9", "max");
+}
+
+static void print_row(const std::string& label, int n, const lat::Stats& s) {
+    std::printf("%-22s %4d %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                label.c_str(), n, s.p50 / 100.0, s.p90 / 100.0,
+                s.p99 / 100.0, s.p999 / 100.0, s.max / 100.0);
+}
+
+static size_t way_size(int name_size, int name_assoc, int name_line, size_t fallback) {
+    const long size  = sysconf(name_size);
+    const long assoc = sysconf(name_assoc);
+    const long line  = sysconf(name_line);
+    if (size <= 0 || assoc <= 0 || line <= 0) return fallback;
+    // sets * line == size / assoc; round down to a power of two.
+    size_t w = (size_t)size / (size_t)assoc;
+    size_t p = 1;
+    while (p * 2 <= w) p *= 2;
+    return p;
+}
+
+static void run_conflicts(const char* name, size_t stride, int ways) {
+    std::printf("\n-- %s: stride %s (ways=%d) vs padded --\n",
+                name, lat::format_bytes(stride).c_str(), ways);
+    print_header();
+
+    const size_t padded = stride + LINE;
+    Region r = map_region((size_t)MAX_N * padded + LINE);
+    if (!r.base) return;
+
+    std::vector<int> ns = {1, 2, 4, 8};
+    if (ways > 0) {
+        for (int n : {ways - 1, ways, ways + 1, ways + 2}) {
+            if (n > 8) ns.push_back(n);
+        }
+    }
+    ns.push_back(32);
+    ns.push_back(MAX_N);
+
+    for (int n : ns) {
+        if (n > MAX_N) continue;
+        print_row(lat::format_bytes(stride), n, measure_chase(r.base, stride, n));
+        print_row(lat::format_bytes(stride) + " + 64B", n, measure_chase(r.base, padded, n));
+    }
+    unmap_region(r);
+}
+
+// ------------------------------------------------------------
+// 4K aliasing: store then load, offset apart.
+// ------------------------------------------------------------
+constexpr int ALIAS_ELEMS = 256; // 1 KB of uint32: stays in L1
+
+__attribute__((noinline)) static uint32_t store_load_pass(volatile uint32_t* dst,
+                                                          const volatile uint32_t* src) {
+    uint32_t acc = 0;
+    for (int i = 0; i < ALIAS_ELEMS; i++) {
+        dst[i] = (uint32_t)i;
+        acc += src[i];
+    }
+    return acc;
+}
+
+static void run_aliasing() {
+    std::printf("\n-- 4K aliasing: store dst[i], load src[i] (ns per element) --\n");
+    std::printf("%-22s %9s %9s %9s %9s %9s\n", "src - dst", "p50", "p90", "p99", "p99.9", "max");
+
+    Region r = map_region(4 * 4096);
+    if (!r.base) return;
+
+    for (size_t off : {(size_t)4096, (size_t)4096 + LINE, (size_t)4096 + 4 * LINE, (size_t)8192}) {
+        auto* dst = reinterpret_cast<volatile uint32_t*>(r.base);
+        auto* src = reinterpret_cast<const volatile uint32_t*>(r.base + off);
+        for (int w = 0; w < 1000; w++) sink = sink + store_load_pass(dst, src);
+
+        std::vector<uint64_t> samples;
+        samples.reserve(SAMPLES);
+        for (int s = 0; s < SAMPLES; s++) {
+            const auto t0 = Clock::now();
+            sink = sink + store_load_pass(dst, src);
+            const auto t1 = Clock::now();
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+            samples.push_back((uint64_t)ns * 100 / ALIAS_ELEMS);
+        }
+        const lat::Stats s = lat::compute_stats(samples);
+        const bool aliased = (off % 4096) == 0;
+        std::printf("%-22s %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                    (std::to_string(off) + (aliased ? " (alias)" : "")).c_str(),
+                    s.p50 / 100.0, s.p90 / 100.0, s.p99 / 100.0,
+                    s.p999 / 100.0, s.max / 100.0);
+    }
+    unmap_region(r);
+}
+
+int main(int argc, char** argv) {
+    std::string only = argc >= 2 ? argv[1] : "";
+
+    const size_t l1_way  = way_size(_SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL1_DCACHE_ASSOC,
+                                    _SC_LEVEL1_DCACHE_LINESIZE, 4096);
+    const size_t l2_way  = way_size(_SC_LEVEL2_CACHE_SIZE, _SC_LEVEL2_CACHE_ASSOC,
+                                    _SC_LEVEL2_CACHE_LINESIZE, 64 * 1024);
+    const size_t llc_way = way_size(_SC_LEVEL3_CACHE_SIZE, _SC_LEVEL3_CACHE_ASSOC,
+                                    _SC_LEVEL3_CACHE_LINESIZE, 1024 * 1024);
+
+    std::printf("=== Cache associativity conflicts & 4K aliasing (ns per access) ===\n");
+    std::printf("L1d: %ld B, %ld-way | L2: %ld B, %ld-way | L3: %ld B, %ld-way\n",
+                sysconf(_SC_LEVEL1_DCACHE_SIZE), sysconf(_SC_LEVEL1_DCACHE_ASSOC),
+                sysconf(_SC_LEVEL2_CACHE_SIZE), sysconf(_SC_LEVEL2_CACHE_ASSOC),
+                sysconf(_SC_LEVEL3_CACHE_SIZE), sysconf(_SC_LEVEL3_CACHE_ASSOC));
+
+    if (only.empty() || only == "l1")
+        run_conflicts("L1 way (4 KiB)", l1_way, (int)sysconf(_SC_LEVEL1_DCACHE_ASSOC));
+    if (only.empty() || only == "l2")
+        run_conflicts("L2 way", l2_way, (int)sysconf(_SC_LEVEL2_CACHE_ASSOC));
+    if (only.empty() || only == "llc")
+        run_conflicts("LLC way (slice-hashed)", llc_way, (int)sysconf(_SC_LEVEL3_CACHE_ASSOC));
+    if (only.empty() || only == "alias")
+        run_aliasing();
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  A cliff at N == ways for the power-of-two stride but not for the\n");
+    std::printf("  padded one is a set conflict. Pad power-of-two sized arrays.\n");
+    std::printf("  A slower 'alias' row in the last table is 4K aliasing; offset\n");
+    std::printf("  buffers that are read and written together by a cache line or more.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// Compare, on a buffer larger than the LLC:
+//
+// READ side (random gather, one load per cache line):
+//   load           plain loads
+//   prefetch-D     __builtin_prefetch D lines ahead in the index stream
+//
+// WRITE side (sequential fill, 64 B per cache line):
+//   store          regular stores (read-for-ownership, then write-back later)
+//   nt             non-temporal streaming stores (movnti), sfence per chunk
+//   clwb           regular stores + clwb each line after writing it
+//
+// For each: throughput (GB/s) and per-chunk latency percentiles
+// (one sample = one 4 KB chunk, 64 cache lines).
+//
+// VICTIM: while each workload runs, a second thread pointer-chases a
+// small LLC-resident working set and records its own per-access
+// latency. That is the "latency-critical neighbour" of a log writer.
+//
+// THEORY:
+// - Regular stores to a cold line first READ it (RFO), doubling memory
+//   traffic, and fill the LLC with data nobody will read again.
+// - NT stores skip the RFO and bypass the cache: higher throughput,
+//   and the victim's lines are not evicted.
+// - But NT stores to memory that IS re-read soon are a loss, and a
+//   single partial line in the write-combining buffer is expensive.
+// - clwb writes back but (on most cores) keeps the line; it does not
+//   save the RFO or the pollution.
+// - Software prefetch helps irregular access only when the distance
+//   covers memory latency; too short is useless, too far is evicted.
+// ------------------------------------------------------------
+
+constexpr size_t LINE        = 64;
+constexpr size_t CHUNK       = 4096;
+constexpr int    PASSES      = 3;
+constexpr int    VICTIM_STEP = 64;
+
+volatile uint64_t sink = 0;
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static char* map_buffer(size_t bytes) {
+    void* m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) { std::perror("mmap"); return nullptr; }
+    madvise(m, bytes, MADV_HUGEPAGE);
+    std::memset(m, 1, bytes); // pre-fault: we measure caches, not page faults
+    return static_cast<char*>(m);
+}
+
+// ------------------------------------------------------------
+// Victim: pointer chase over an LLC-resident random cycle.
+// ------------------------------------------------------------
+struct Victim {
+    char* base = nullptr;
+    size_t bytes = 0;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> ready{false}; // warmup pass done, sampling started
+    std::vector<uint64_t> samples;
+
+    explicit Victim(size_t b) : bytes(b) {
+        base = map_buffer(bytes);
+        const size_t lines = bytes / LINE;
+        std::vector<size_t> order(lines);
+        std::iota(order.begin(), order.end(), 0);
+        std::mt19937_64 rng(7);
+        std::shuffle(order.begin() + 1, order.end(), rng);
+        for (size_t i = 0; i < lines; i++) {
+            char* next = base + order[(i + 1) % lines] * LINE;
+            std::memcpy(base + order[i] * LINE, &next, sizeof(next));
+        }
+        samples.reserve(4'000'000);
+    }
+    ~Victim() { if (base) munmap(base, bytes); }
+
+    void wait_ready() const {
+        while (!ready.load(std::memory_order_acquire)) std::this_thread::yield();
+    }
+
+    void run(int cpu) {
+        pin_to(cpu);
+        void* p = base;
+        // One untimed pass over the whole chain: page tables, TLB and
+        // cache are warm before the first sample, for every row alike.
+        for (size_t i = 0; i < bytes / LINE; i++) p = *static_cast<void**>(p);
+        ready.store(true, std::memory_order_release);
+        while (!stop.load(std::memory_order_relaxed)) {
+            const auto t0 = Clock::now();
+            for (int i = 0; i < VICTIM_STEP; i++) p = *static_cast<void**>(p);
+            const auto t1 = Clock::now();
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+            if (samples.size() < samples.capacity()) {
+                samples.push_back((uint64_t)ns * 100 / VICTIM_STEP);
+            }
+        }
+        sink = sink + (uint64_t)(uintptr_t)p;
+    }
+};
+
+// ------------------------------------------------------------
+// Workloads: each processes one 4 KB chunk starting at line `first`.
+// ------------------------------------------------------------
+enum class Kind { Load, Prefetch, Store, Nt, Clwb };
+
+struct Workload {
+    std::string label;
+    Kind kind;
+    int  distance = 0; // prefetch distance in lines
+};
+
+__attribute__((noinline)) static uint64_t gather_chunk(const char* buf, const uint32_t* idx,
+                                                       size_t first, size_t n_idx, int dist) {
+    uint64_t acc = 0;
+    const size_t lines = CHUNK / LINE;
+    for (size_t i = first; i < first + lines; i++) {
+        if (dist > 0 && i + (size_t)dist < n_idx) {
+            __builtin_prefetch(buf + (size_t)idx[i + dist] * LINE, 0, 3);
+        }
+        acc += *reinterpret_cast<const volatile uint64_t*>(buf + (size_t)idx[i] * LINE);
+    }
+    return acc;
+}
+
+__attribute__((noinline)) static void store_chunk(char* dst, uint64_t v) {
+    auto* p = reinterpret_cast<uint64_t*>(dst);
+    for (size_t i = 0; i < CHUNK / sizeof(uint64_t); i++) p[i] = v;
+    asm volatile("" ::: "memory");
+}
+
+__attribute__((noinline)) static void nt_chunk(char* dst, uint64_t v) {
+#if defined(__x86_64__)
+    auto* p = reinterpret_cast<long long*>(dst);
+    for (size_t i = 0; i < CHUNK / sizeof(long long); i++) _mm_stream_si64(p + i, (long long)v);
+    _mm_sfence();
+#else
+    store_chunk(dst, v);
+#endif
+}
+
+__attribute__((noinline)) static void clwb_chunk(char* dst, uint64_t v) {
+    auto* p = reinterpret_cast<uint64_t*>(dst);
+    for (size_t line = 0; line < CHUNK / LINE; line++) {
+        for (size_t k = 0; k < LINE / sizeof(uint64_t); k++) p[line * 8 + k] = v;
+#if defined(__CLWB__)
+        _mm_clwb(p + line * 8);
+#endif
+    }
+#if defined(__CLWB__)
+    _mm_sfence();
+#endif
+}
+
+struct Result {
+    lat::Stats chunk;
+    double gbps = 0.0;
+};
+
+static Result run_workload(const Workload& w, char* buf, size_t bytes, const std::vector<uint32_t>& idx) {
+    const size_t chunks = bytes / CHUNK;
+    std::vector<uint64_t> samples;
+    samples.reserve(chunks * PASSES);
+
+    const auto start = Clock::now();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (size_t c = 0; c < chunks; c++) {
+            char* dst = buf + c * CHUNK;
+            const auto t0 = Clock::now();
+            switch (w.kind) {
+                case Kind::Load:
+                case Kind::Prefetch:
+                    sink = sink + gather_chunk(buf, idx.data(), c * (CHUNK / LINE), idx.size(), w.distance);
+                    break;
+                case Kind::Store: store_chunk(dst, (uint64_t)pass); break;
+                case Kind::Nt:    nt_chunk(dst, (uint64_t)pass);    break;
+                case Kind::Clwb:  clwb_chunk(dst, (uint64_t)pass);  break;
+            }
+            const auto t1 = Clock::now();
+            samples.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        }
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Result r;
+    r.chunk = lat::compute_stats(std::move(samples));
+    // Every workload touches each cache line of the buffer once per pass.
+    r.gbps = (double)bytes * PASSES / secs / 1e9;
+    return r;
+}
+
+static void print_header() {
+    std::printf("%-14s %8s | %9s %9s %9s %9s %10s | %8s %8s %8s %9s\n",
+                "workload", "GB/s", "chunk p50", "p90", "p99", "p99.9", "max",
+                "vic p50", "p99", "p99.9", "max");
+}
+
+static void print_row(const std::string& label, const Result& r, const lat::Stats* v) {
+    if (r.chunk.n == 0) {
+        std::printf("%-14s %8s | %9s %9s %9s %9s %10s |",
+                    label.c_str(), "-", "-", "-", "-", "-", "-");
+    } else {
+        std::printf("%-14s %8.2f | %9llu %9llu %9llu %9llu %10llu |",
+                    label.c_str(), r.gbps,
+                    (unsigned long long)r.chunk.p50, (unsigned long long)r.chunk.p90,
+                    (unsigned long long)r.chunk.p99, (unsigned long long)r.chunk.p999,
+                    (unsigned long long)r.chunk.max);
+    }
+    if (v) {
+        std::printf(" %8.2f %8.2f %8.2f %9.2f\n",
+                    v->p50 / 100.0, v->p99 / 100.0, v->p999 / 100.0, v->max / 100.0);
+    } else {
+        std::printf(" %8s %8s %8s %9s\n", "-", "-", "-", "-");
+    }
+}
+
+static size_t default_buffer_bytes() {
+    // 2x the LLC, clamped to [128 MB, 1 GB].
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    size_t b = llc > 0 ? (size_t)llc * 2 : (size_t)256 << 20;
+    b = std::clamp(b, (size_t)128 << 20, (size_t)1 << 30);
+    return b & ~(CHUNK - 1);
+}
+
+int main(int argc, char** argv) {
+    size_t bytes = default_buffer_bytes();
+    bool victim_on = true;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--mb=", 0) == 0) bytes = (std::stoull(a.substr(5)) << 20) & ~(CHUNK - 1);
+        else if (a == "--no-victim") victim_on = false;
+    }
+
+#if !defined(__x86_64__)
+    std::printf("NOTE: non-x86 build: 'nt' and 'clwb' fall back to regular stores.\n");
+#elif !defined(__CLWB__)
+    std::printf("NOTE: built without CLWB support (-march): 'clwb' row is regular stores.\n");
+#endif
+
+    const int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    std::printf("=== Software prefetch & non-temporal stores ===\n");
+    std::printf("buffer %s (LLC %ld B), %d passes, chunk %zu B; victim %s\n",
+                lat::format_bytes(bytes).c_str(), sysconf(_SC_LEVEL3_CACHE_SIZE), PASSES, CHUNK,
+                !victim_on ? "off" : (ncpu > 1 ? "on CPU 1" : "sharing CPU 0 (1 CPU online)"));
+    std::printf("chunk latency in ns per 4 KB; victim latency in ns per access\n\n");
+
+    pin_to(0);
+    char* buf = map_buffer(bytes);
+    if (!buf) return 1;
+
+    // Random line order for the gather workloads.
+    std::vector<uint32_t> idx(bytes / LINE);
+    std::iota(idx.begin(), idx.end(), 0u);
+    std::mt19937_64 rng(42);
+    std::shuffle(idx.begin(), idx.end(), rng);
+
+    // Victim sized to stay LLC-resident on its own.
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    const size_t victim_bytes = std::clamp(llc > 0 ? (size_t)llc / 4 : (size_t)2 << 20,
+                                           (size_t)1 << 20, (size_t)8 << 20);
+
+    const std::vector<Workload> workloads = {
+        {"load",         Kind::Load,     0},
+        {"prefetch-1",   Kind::Prefetch, 1},
+        {"prefetch-4",   Kind::Prefetch, 4},
+        {"prefetch-16",  Kind::Prefetch, 16},
+        {"prefetch-64",  Kind::Prefetch, 64},
+        {"prefetch-256", Kind::Prefetch, 256},
+        {"store",        Kind::Store,    0},
+        {"nt",           Kind::Nt,       0},
+        {"clwb",         Kind::Clwb,     0},
+    };
+
+    print_header();
+
+    // Victim alone: the reference its rows are compared against.
+    if (victim_on) {
+        Victim v(victim_bytes);
+        std::thread th([&] { v.run(1); });
+        v.wait_ready();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        v.stop.store(true);
+        th.join();
+        const lat::Stats vs = lat::compute_stats(v.samples);
+        print_row("(victim only)", Result{}, &vs);
+    }
+
+    for (const auto& w : workloads) {
+        if (victim_on) {
+            Victim v(victim_bytes);
+            std::thread th([&] { v.run(1); });
+            v.wait_ready();
+            const Result r = run_workload(w, buf, bytes, idx);
+            v.stop.store(true);
+            th.join();
+            const lat::Stats vs = lat::compute_stats(v.samples);
+            print_row(w.label, r, &vs);
+        } else {
+            print_row(w.label, run_workload(w, buf, bytes, idx), nullptr);
+        }
+    }
+
+    munmap(buf, bytes);
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  prefetch-D: the best D is the one whose chunk p50 is lowest;\n");
+    std::printf("  past it, prefetched lines are evicted before use.\n");
+    std::printf("  nt vs store: higher GB/s AND a victim tail closer to 'victim only'\n");
+    std::printf("  means streaming stores protect the neighbour. clwb rarely does.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
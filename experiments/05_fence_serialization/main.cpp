@@ -0,0 +1,316 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "../common/stats.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// Cost, in TSC cycles, of the instructions used to order memory and
+// to fence timestamps:
+//
+//   mfence   full barrier: waits for the store buffer to drain
+//   sfence   orders stores (only matters for NT / WC stores)
+//   lfence   waits for earlier instructions to complete locally
+//   lock     `lock addl $0,(%rsp)`: the usual cheaper full barrier
+//   cpuid    architecturally serializing, and a VM exit under virtualization
+//   serialize  dedicated serializing instruction (newer cores only)
+//
+// Each is measured
+//   - alone,
+//   - after 8 stores that hit L1,
+//   - after 8 stores that miss (lines scattered over a large buffer),
+// because a barrier's cost is mostly "wait for pending stores".
+//
+// Second table: cost of timestamp sequences you could put around a
+// hot path (rdtsc, lfence;rdtsc, rdtscp, cpuid;rdtsc, clock_gettime).
+//
+// Timing: lfence; rdtsc; lfence ... rdtscp; lfence around a block of
+// REPS repetitions, reported per repetition. The "net p50" column
+// subtracts the p50 of the same block without the instruction
+// (i.e. the stores alone).
+//
+// Cycles are TSC reference cycles, not core cycles; the TSC rate is
+// printed so they can be converted to ns.
+// ------------------------------------------------------------
+
+#if !defined(__x86_64__)
+
+int main() {
+    std::printf("This experiment uses x86-64 instructions (mfence, rdtsc, cpuid, ...).\n");
+    return 0;
+}
+
+#else
+
+constexpr int REPS    = 32;
+constexpr int SAMPLES = 20'000;
+constexpr int STORES  = 8;
+
+volatile uint64_t sink = 0;
+
+static inline uint64_t tsc_begin() {
+    _mm_lfence();
+    const uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+}
+
+static inline uint64_t tsc_end() {
+    unsigned aux;
+    const uint64_t t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+}
+
+static bool cpu_has_serialize() {
+    unsigned a, b, c, d;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+    return (d >> 14) & 1;
+}
+
+enum class Insn { None, Mfence, Sfence, Lfence, Lock, Cpuid, Serialize };
+
+static const char* insn_name(Insn i) {
+    switch (i) {
+        case Insn::None:      return "(none)";
+        case Insn::Mfence:    return "mfence";
+        case Insn::Sfence:    return "sfence";
+        case Insn::Lfence:    return "lfence";
+        case Insn::Lock:      return "lock add";
+        case Insn::Cpuid:     return "cpuid";
+        case Insn::Serialize: return "serialize";
+    }
+    return "?";
+}
+
+template <Insn I>
+static inline __attribute__((always_inline)) void emit() {
+    if constexpr (I == Insn::Mfence) {
+        asm volatile("mfence" ::: "memory");
+    } else if constexpr (I == Insn::Sfence) {
+        asm volatile("sfence" ::: "memory");
+    } else if constexpr (I == Insn::Lfence) {
+        asm volatile("lfence" ::: "memory");
+    } else if constexpr (I == Insn::Lock) {
+        asm volatile("lock addl $0, (%%rsp)" ::: "memory", "cc");
+    } else if constexpr (I == Insn::Cpuid) {
+        unsigned a = 0, b, c = 0, d;
+        asm volatile("cpuid" : "+a"(a), "=b"(b), "+c"(c), "=d"(d) :: "memory");
+    } else if constexpr (I == Insn::Serialize) {
+        asm volatile(".byte 0x0f, 0x01, 0xe8" ::: "memory"); // SERIALIZE
+    }
+}
+
+// Where the STORES pending stores land before each instruction.
+enum class Pending { None, L1, Miss };
+
+struct StoreTarget {
+    char*  base = nullptr;
+    size_t bytes = 0;  // power of two
+    size_t stride = 0; // in lines, odd: the walk visits every line once per cycle
+    size_t cursor = 0;
+
+    // L1: the same 8 lines every time. Miss: stride through a large
+    // buffer by ~0.618 of its size, so every store is to a line not
+    // touched for a long time and consecutive stores are ~100 MB apart.
+    // A sequential walk would let the hardware prefetcher hide the misses.
+    inline char* next_line(Pending p) {
+        if (p == Pending::L1) return base + (cursor++ % STORES) * 64;
+        cursor = (cursor + stride) & (bytes / 64 - 1);
+        return base + cursor * 64;
+    }
+};
+
+template <Insn I>
+__attribute__((noinline)) static uint64_t block(Pending p, StoreTarget& st) {
+    const uint64_t t0 = tsc_begin();
+    for (int r = 0; r < REPS; r++) {
+        if (p != Pending::None) {
+            for (int k = 0; k < STORES; k++) {
+                *reinterpret_cast<volatile uint64_t*>(st.next_line(p)) = (uint64_t)r;
+            }
+        }
+        emit<I>();
+    }
+    const uint64_t t1 = tsc_end();
+    return t1 - t0;
+}
+
+// Samples are cycles per repetition x100.
+template <Insn I>
+static lat::Stats measure(Pending p, StoreTarget& st) {
+    for (int i = 0; i < 500; i++) sink = sink + block<I>(p, st);
+    std::vector<uint64_t> samples;
+    samples.reserve(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++) samples.push_back(block<I>(p, st) * 100 / REPS);
+    return lat::compute_stats(samples);
+}
+
+static void row(const char* name, const char* pending, const lat::Stats& s, const lat::Stats& base) {
+    const double net = (double)s.p50 / 100.0 - (double)base.p50 / 100.0;
+    std::printf("%-11s %-10s %9.1f %9.1f %9.1f %9.1f %10.1f %9.1f\n",
+                name, pending, s.p50 / 100.0, s.p90 / 100.0, s.p99 / 100.0,
+                s.p999 / 100.0, s.max / 100.0, net);
+}
+
+template <Insn I>
+static void run_insn(StoreTarget& st, const lat::Stats base[3]) {
+    const char* pnames[3] = {"alone", "+8 L1 st", "+8 miss st"};
+    const Pending ps[3] = {Pending::None, Pending::L1, Pending::Miss};
+    for (int k = 0; k < 3; k++) {
+        row(insn_name(I), pnames[k], measure<I>(ps[k], st), base[k]);
+    }
+}
+
+// ------------------------------------------------------------
+// Timestamp sequences
+// ------------------------------------------------------------
+enum class Ts { Rdtsc, LfenceRdtsc, Rdtscp, RdtscpLfence, CpuidRdtsc, ClockGettime, SteadyNow };
+
+static const char* ts_name(Ts t) {
+    switch (t) {
+        case Ts::Rdtsc:        return "rdtsc";
+        case Ts::LfenceRdtsc:  return "lfence; rdtsc";
+        case Ts::Rdtscp:       return "rdtscp";
+        case Ts::RdtscpLfence: return "rdtscp; lfence";
+        case Ts::CpuidRdtsc:   return "cpuid; rdtsc";
+        case Ts::ClockGettime: return "clock_gettime(MONO)";
+        case Ts::SteadyNow:    return "steady_clock::now";
+    }
+    return "?";
+}
+
+template <Ts T>
+static inline __attribute__((always_inline)) uint64_t stamp() {
+    if constexpr (T == Ts::Rdtsc) {
+        return __rdtsc();
+    } else if constexpr (T == Ts::LfenceRdtsc) {
+        _mm_lfence();
+        return __rdtsc();
+    } else if constexpr (T == Ts::Rdtscp) {
+        unsigned aux;
+        return __rdtscp(&aux);
+    } else if constexpr (T == Ts::RdtscpLfence) {
+        unsigned aux;
+        const uint64_t t = __rdtscp(&aux);
+        _mm_lfence();
+        return t;
+    } else if constexpr (T == Ts::CpuidRdtsc) {
+        emit<Insn::Cpuid>();
+        return __rdtsc();
+    } else if constexpr (T == Ts::ClockGettime) {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_nsec;
+    } else {
+        return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+}
+
+template <Ts T>
+__attribute__((noinline)) static uint64_t ts_block() {
+    uint64_t acc = 0;
+    const uint64_t t0 = tsc_begin();
+    for (int r = 0; r < REPS; r++) acc += stamp<T>();
+    const uint64_t t1 = tsc_end();
+    sink = sink + acc;
+    return t1 - t0;
+}
+
+template <Ts T>
+static void run_ts() {
+    for (int i = 0; i < 500; i++) sink = sink + ts_block<T>();
+    std::vector<uint64_t> samples;
+    samples.reserve(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++) samples.push_back(ts_block<T>() * 100 / REPS);
+    const lat::Stats s = lat::compute_stats(samples);
+    std::printf("%-22s %9.1f %9.1f %9.1f %9.1f %10.1f\n",
+                ts_name(T), s.p50 / 100.0, s.p90 / 100.0, s.p99 / 100.0,
+                s.p999 / 100.0, s.max / 100.0);
+}
+
+static double tsc_ghz() {
+    const auto c0 = std::chrono::steady_clock::now();
+    const uint64_t t0 = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const uint64_t t1 = __rdtsc();
+    const auto c1 = std::chrono::steady_clock::now();
+    const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(c1 - c0).count();
+    return (double)(t1 - t0) / ns;
+}
+
+int main(int argc, char** argv) {
+    const bool has_serialize = cpu_has_serialize();
+    const std::string only = argc >= 2 ? argv[1] : "";
+
+    std::printf("=== Fence & serialization cost (TSC cycles per instruction) ===\n");
+    std::printf("TSC: %.3f GHz (cycles / this = ns); SERIALIZE: %s\n",
+                tsc_ghz(), has_serialize ? "yes" : "not supported");
+
+    StoreTarget st;
+    st.bytes = 256ull << 20;
+    void* m = mmap(nullptr, st.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) { std::perror("mmap"); return 1; }
+    st.base = static_cast<char*>(m);
+    st.stride = (size_t)((double)(st.bytes / 64) * 0.6180339887) | 1;
+    madvise(st.base, st.bytes, MADV_HUGEPAGE); // scattered stores: keep them off the TLB
+    std::memset(st.base, 0, st.bytes); // pre-fault: stores miss cache, not page tables
+
+    if (only.empty() || only == "fences") {
+        std::printf("\n%-11s %-10s %9s %9s %9s %9s %10s %9s\n",
+                    "insn", "pending", "p50", "p90", "p99", "p99.9", "max", "net p50");
+
+        const lat::Stats base[3] = {
+            measure<Insn::None>(Pending::None, st),
+            measure<Insn::None>(Pending::L1, st),
+            measure<Insn::None>(Pending::Miss, st),
+        };
+        run_insn<Insn::None>(st, base);
+        run_insn<Insn::Mfence>(st, base);
+        run_insn<Insn::Sfence>(st, base);
+        run_insn<Insn::Lfence>(st, base);
+        run_insn<Insn::Lock>(st, base);
+        run_insn<Insn::Cpuid>(st, base);
+        if (has_serialize) run_insn<Insn::Serialize>(st, base);
+    }
+
+    if (only.empty() || only == "timestamps") {
+        std::printf("\n%-22s %9s %9s %9s %9s %10s\n",
+                    "timestamp sequence", "p50", "p90", "p99", "p99.9", "max");
+        run_ts<Ts::Rdtsc>();
+        run_ts<Ts::LfenceRdtsc>();
+        run_ts<Ts::Rdtscp>();
+        run_ts<Ts::RdtscpLfence>();
+        run_ts<Ts::CpuidRdtsc>();
+        run_ts<Ts::ClockGettime>();
+        run_ts<Ts::SteadyNow>();
+    }
+
+    munmap(m, st.bytes);
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  'net p50' is what the instruction adds on top of the stores alone.\n");
+    std::printf("  mfence / lock grow with pending missing stores: they drain the store buffer.\n");
+    std::printf("  lfence does not wait for stores; it is the cheap way to order rdtsc.\n");
+    std::printf("  cpuid is expensive everywhere and a VM exit under virtualization.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// One writer publishes a multi-cache-line snapshot (think top-of-book)
+// at a fixed rate. N readers copy it as fast as they can.
+// How long does ONE read take, and how often does it have to retry?
+//
+//   mutex         std::mutex around read and write
+//   shared_mutex  readers take a shared lock, writer exclusive
+//   seqlock       sequence counter; readers retry on a torn read
+//   rcu           writer publishes a fresh copy by pointer swap;
+//                 readers never wait; old copies reclaimed by epoch
+//
+// Every snapshot holds the same value in every word, so readers can
+// verify consistency: a "torn" read is a correctness bug, not noise.
+//
+// THEORY (extends Experiment 02's cache-coherence theme):
+// - mutex / shared_mutex: every reader WRITES the lock word, so readers
+//   ping-pong a cache line among themselves even with no writer.
+// - seqlock: readers only READ the counter; no reader-reader traffic,
+//   but a write in progress forces a retry.
+// - rcu: readers read a pointer and immutable data; the writer pays
+//   for allocation and reclamation instead.
+// ------------------------------------------------------------
+
+constexpr int WORDS = 32; // 256 B = 4 cache lines
+
+volatile uint64_t sink = 0;
+
+struct Snapshot {
+    uint64_t w[WORDS];
+};
+
+static void fill(Snapshot& s, uint64_t v) {
+    for (int i = 0; i < WORDS; i++) s.w[i] = v;
+}
+
+static bool consistent(const Snapshot& s) {
+    for (int i = 1; i < WORDS; i++) {
+        if (s.w[i] != s.w[0]) return false;
+    }
+    return true;
+}
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// ------------------------------------------------------------
+// Mechanisms. Each provides:
+//   write(v)                  publish a snapshot whose words are all v
+//   read(out) -> retries      copy the current snapshot into out
+// ------------------------------------------------------------
+
+struct MutexBook {
+    static constexpr const char* name = "mutex";
+    alignas(64) std::mutex m;
+    Snapshot s{};
+
+    void write(uint64_t v) {
+        std::lock_guard<std::mutex> g(m);
+        fill(s, v);
+    }
+    uint64_t read(Snapshot& out) {
+        std::lock_guard<std::mutex> g(m);
+        out = s;
+        return 0;
+    }
+};
+
+struct SharedMutexBook {
+    static constexpr const char* name = "shared_mutex";
+    alignas(64) std::shared_mutex m;
+    Snapshot s{};
+
+    void write(uint64_t v) {
+        std::unique_lock<std::shared_mutex> g(m);
+        fill(s, v);
+    }
+    uint64_t read(Snapshot& out) {
+        std::shared_lock<std::shared_mutex> g(m);
+        out = s;
+        return 0;
+    }
+};
+
+struct SeqlockBook {
+    static constexpr const char* name = "seqlock";
+    alignas(64) std::atomic<uint64_t> seq{0};
+    // Words are relaxed atomics so the concurrent copy is well-defined;
+    // on x86 they compile to plain moves.
+    alignas(64) std::atomic<uint64_t> w[WORDS]{};
+
+    void write(uint64_t v) {
+        const uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);          // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = 0; i < WORDS; i++) w[i].store(v, std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);          // even: stable
+    }
+    uint64_t read(Snapshot& out) {
+        uint64_t retries = 0;
+        for (;;) {
+            uint64_t s1 = seq.load(std::memory_order_acquire);
+            if (s1 & 1) {
+                // Write in progress: wait it out, count it as one retry.
+                retries++;
+                while ((s1 = seq.load(std::memory_order_acquire)) & 1) cpu_relax();
+            }
+            for (int i = 0; i < WORDS; i++) out.w[i] = w[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s1) return retries;
+            retries++;
+        }
+    }
+};
+
+// RCU-style: immutable nodes, pointer swap, epoch-based reclamation.
+// Nodes come from a writer-owned pool, so the writer never mallocs
+// in steady state; a node returns to the pool once no reader that
+// could have seen it is still inside a read.
+struct RcuBook {
+    static constexpr const char* name = "rcu";
+    static constexpr uint64_t IDLE = ~0ull;
+    static constexpr int MAX_READERS = 256;
+
+    struct alignas(64) Node {
+        Snapshot s;
+        uint64_t retired_at = 0;
+    };
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{IDLE};
+    };
+
+    alignas(64) std::atomic<Node*> current{nullptr};
+    alignas(64) std::atomic<uint64_t> global_epoch{1};
+    Slot slots[MAX_READERS];
+    int  active_slots = MAX_READERS; // only slots [0, active_slots) are scanned
+
+    // Writer-only state.
+    std::vector<Node*> pool;
+    std::vector<Node*> retired;
+    std::vector<Node*> owned;
+    size_t max_backlog = 0;
+
+    RcuBook() {
+        for (int i = 0; i < 64; i++) owned.push_back(new Node{});
+        pool = owned;
+        Node* first = pool.back();
+        pool.pop_back();
+        fill(first->s, 0);
+        current.store(first, std::memory_order_release);
+    }
+    ~RcuBook() {
+        for (Node* n : owned) delete n;
+    }
+
+    void write(uint64_t v) {
+        if (pool.empty()) reclaim();
+        if (pool.empty()) {
+            owned.push_back(new Node{}); // readers are slow to leave: grow
+            pool.push_back(owned.back());
+        }
+        Node* n = pool.back();
+        pool.pop_back();
+        fill(n->s, v);
+
+        Node* old = current.exchange(n, std::memory_order_seq_cst);
+        old->retired_at = global_epoch.fetch_add(1, std::memory_order_seq_cst);
+        retired.push_back(old);
+        max_backlog = std::max(max_backlog, retired.size());
+        reclaim();
+    }
+
+    void reclaim() {
+        // Oldest epoch any reader is currently inside.
+        uint64_t min_active = IDLE;
+        for (int i = 0; i < active_slots; i++) {
+            min_active = std::min(min_active, slots[i].epoch.load(std::memory_order_seq_cst));
+        }
+        auto it = std::remove_if(retired.begin(), retired.end(), [&](Node* n) {
+            if (n->retired_at < min_active) {
+                pool.push_back(n);
+                return true;
+            }
+            return false;
+        });
+        retired.erase(it, retired.end());
+    }
+
+    uint64_t read(Snapshot& out, int reader) {
+        Slot& slot = slots[reader];
+        slot.epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        const Node* n = current.load(std::memory_order_seq_cst);
+        out = n->s;
+        slot.epoch.store(IDLE, std::memory_order_release);
+        return 0;
+    }
+};
+
+// ------------------------------------------------------------
+// Runner
+// ------------------------------------------------------------
+
+struct Config {
+    int    readers = 1;
+    double seconds = 1.0;
+    long   rate = 100'000; // writer updates per second; 0 = as fast as possible
+};
+
+// One line per reader: the counters are bumped on every read, and
+// packed results would put coherence misses into the scaling we measure.
+struct alignas(64) ReaderResult {
+    std::vector<uint64_t> samples;
+    uint64_t reads = 0;
+    uint64_t retries = 0;
+    uint64_t torn = 0;
+    uint64_t last = 0; // last snapshot's w[0]; folded into sink after join
+};
+
+template <typename Book>
+static uint64_t do_read(Book& b, Snapshot& out, int reader) {
+    if constexpr (std::is_same_v<Book, RcuBook>) return b.read(out, reader);
+    else { (void)reader; return b.read(out); }
+}
+
+template <typename Book>
+static void run_book(const Config& cfg) {
+    Book book;
+    if constexpr (std::is_same_v<Book, RcuBook>) book.active_slots = cfg.readers;
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::vector<ReaderResult> results(cfg.readers);
+    const size_t cap = (size_t)(cfg.seconds * 4'000'000);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < cfg.readers; r++) {
+        readers.emplace_back([&, r] {
+            pin_to(r + 1);
+            ReaderResult& res = results[r];
+            res.samples.reserve(cap);
+            Snapshot snap{};
+            while (!start.load(std::memory_order_acquire)) {}
+            while (!stop.load(std::memory_order_relaxed)) {
+                const auto t0 = Clock::now();
+                const uint64_t retries = do_read(book, snap, r);
+                const auto t1 = Clock::now();
+                if (res.samples.size() < cap) {
+                    res.samples.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                }
+                res.reads++;
+                res.retries += retries;
+                res.torn += consistent(snap) ? 0 : 1;
+            }
+            res.last = snap.w[0];
+        });
+    }
+
+    // Writer: this thread, paced by busy-waiting on deadlines.
+    pin_to(0);
+    uint64_t version = 1;
+    const auto period = cfg.rate > 0 ? std::chrono::nanoseconds(1'000'000'000L / cfg.rate)
+                                     : std::chrono::nanoseconds(0);
+    start.store(true, std::memory_order_release);
+    const auto begin = Clock::now();
+    const auto end = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(cfg.seconds));
+    auto next = begin;
+    while (Clock::now() < end) {
+        if (period.count() > 0) {
+            while (Clock::now() < next) {}
+            next += period;
+        }
+        book.write(version++);
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : readers) t.join();
+
+    std::vector<uint64_t> all;
+    uint64_t reads = 0, retries = 0, torn = 0;
+    for (auto& r : results) {
+        all.insert(all.end(), r.samples.begin(), r.samples.end());
+        reads += r.reads;
+        retries += r.retries;
+        torn += r.torn;
+        sink = sink + r.last;
+    }
+    const lat::Stats s = lat::compute_stats(std::move(all));
+    std::printf("%-13s %8llu %7llu %7llu %7llu %8llu %9llu %11llu %8.3f%% %6llu\n",
+                Book::name, (unsigned long long)(version - 1),
+                (unsigned long long)s.p50, (unsigned long long)s.p90,
+                (unsigned long long)s.p99, (unsigned long long)s.p999,
+                (unsigned long long)s.max, (unsigned long long)reads,
+                reads ? 100.0 * (double)retries / (double)reads : 0.0,
+                (unsigned long long)torn);
+    if constexpr (std::is_same_v<Book, RcuBook>) {
+        std::printf("%-13s max retired-but-unreclaimed nodes: %zu\n", "", book.max_backlog);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int ncpu = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    Config cfg;
+    cfg.readers = std::max(1, ncpu - 1);
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--readers=", 0) == 0) cfg.readers = std::clamp(std::atoi(a.c_str() + 10), 1, RcuBook::MAX_READERS);
+        else if (a.rfind("--rate=", 0) == 0) cfg.rate = std::max(0L, std::atol(a.c_str() + 7));
+        else if (a.rfind("--seconds=", 0) == 0) cfg.seconds = std::max(0.1, std::atof(a.c_str() + 10));
+        else only = a;
+    }
+
+    std::printf("Snapshot readers: 1 writer @ %ld updates/s, %d readers, %d-byte snapshot, %.1fs each\n",
+                cfg.rate, cfg.readers, (int)sizeof(Snapshot), cfg.seconds);
+    if (cfg.readers + 1 > ncpu) {
+        std::printf("NOTE: %d threads on %d CPUs: tails include time-slicing (a preempted lock holder!).\n",
+                    cfg.readers + 1, ncpu);
+    }
+    std::printf("reader latency in ns per read\n");
+    std::printf("%-13s %8s %7s %7s %7s %8s %9s %11s %9s %6s\n",
+                "mechanism", "writes", "p50", "p90", "p99", "p99.9", "max", "reads", "retry", "torn");
+
+    if (only.empty() || only == "mutex")        run_book<MutexBook>(cfg);
+    if (only.empty() || only == "shared_mutex") run_book<SharedMutexBook>(cfg);
+    if (only.empty() || only == "seqlock")      run_book<SeqlockBook>(cfg);
+    if (only.empty() || only == "rcu")          run_book<RcuBook>(cfg);
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  'torn' must be 0 everywhere; anything else is a bug.\n");
+    std::printf("  Locks make readers write shared state: tails grow with reader count.\n");
+    std::printf("  seqlock readers never write; 'retry' is the price of a concurrent write.\n");
+    std::printf("  rcu readers never wait; the writer pays for copies and reclamation.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// Throughput says which lock is fastest ON AVERAGE.
+// This program asks what a latency-critical thread cares about:
+//
+//   acquire   ns from calling lock() to owning the lock
+//   handoff   ns from the previous owner's unlock() to the next
+//             waiter owning it (only counted when someone was waiting)
+//   fairness  min / max share of acquisitions across threads
+//
+// for:
+//   tas          test-and-set spin, no backoff
+//   ttas         test-and-test-and-set with pause
+//   ticket       FIFO ticket lock
+//   mcs          MCS queue lock (each waiter spins on its own node)
+//   clh          CLH queue lock (each waiter spins on its predecessor)
+//   pthread      pthread_mutex, PTHREAD_MUTEX_NORMAL (futex)
+//   adaptive     pthread_mutex, PTHREAD_MUTEX_ADAPTIVE_NP (spin, then futex)
+//   pi           pthread_mutex, PTHREAD_PRIO_INHERIT
+//
+// across thread counts and critical-section sizes.
+//
+// THEORY:
+// - tas hammers the line with RMWs: fast handoff at 2 threads, collapses after.
+// - ticket / mcs / clh are FIFO: perfectly fair, but a preempted waiter
+//   at the head of the queue blocks everyone behind it.
+// - futex mutexes sleep: handoff includes a wakeup (microseconds), but
+//   oversubscribed threads do not burn the holder's CPU.
+// - PI mutexes always go through the kernel on contention.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// ------------------------------------------------------------
+// Locks. Each has a per-thread Node (empty for most) and
+// lock(Node&) / unlock(Node&).
+// ------------------------------------------------------------
+
+struct Empty {};
+
+struct TasLock {
+    static constexpr const char* name = "tas";
+    using Node = Empty;
+    alignas(64) std::atomic<bool> held{false};
+
+    void init_node(Node&) {}
+    void lock(Node&) {
+        while (held.exchange(true, std::memory_order_acquire)) {}
+    }
+    void unlock(Node&) { held.store(false, std::memory_order_release); }
+};
+
+struct TtasLock {
+    static constexpr const char* name = "ttas";
+    using Node = Empty;
+    alignas(64) std::atomic<bool> held{false};
+
+    void init_node(Node&) {}
+    void lock(Node&) {
+        for (;;) {
+            if (!held.exchange(true, std::memory_order_acquire)) return;
+            while (held.load(std::memory_order_relaxed)) cpu_relax();
+        }
+    }
+    void unlock(Node&) { held.store(false, std::memory_order_release); }
+};
+
+struct TicketLock {
+    static constexpr const char* name = "ticket";
+    using Node = Empty;
+    alignas(64) std::atomic<uint32_t> next{0};
+    alignas(64) std::atomic<uint32_t> serving{0};
+
+    void init_node(Node&) {}
+    void lock(Node&) {
+        const uint32_t t = next.fetch_add(1, std::memory_order_relaxed);
+        while (serving.load(std::memory_order_acquire) != t) cpu_relax();
+    }
+    void unlock(Node&) {
+        serving.store(serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
+struct McsLock {
+    static constexpr const char* name = "mcs";
+    struct alignas(64) Node {
+        std::atomic<Node*> next{nullptr};
+        std::atomic<bool>  locked{false};
+    };
+    alignas(64) std::atomic<Node*> tail{nullptr};
+
+    void init_node(Node&) {}
+    void lock(Node& n) {
+        n.next.store(nullptr, std::memory_order_relaxed);
+        n.locked.store(true, std::memory_order_relaxed);
+        Node* prev = tail.exchange(&n, std::memory_order_acq_rel);
+        if (!prev) return;
+        prev->next.store(&n, std::memory_order_release);
+        while (n.locked.load(std::memory_order_acquire)) cpu_relax();
+    }
+    void unlock(Node& n) {
+        Node* succ = n.next.load(std::memory_order_acquire);
+        if (!succ) {
+            Node* expected = &n;
+            if (tail.compare_exchange_strong(expected, nullptr,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+                return;
+            }
+            while (!(succ = n.next.load(std::memory_order_acquire))) cpu_relax();
+        }
+        succ->locked.store(false, std::memory_order_release);
+    }
+};
+
+struct ClhLock {
+    static constexpr const char* name = "clh";
+    struct alignas(64) QNode {
+        std::atomic<bool> locked{false};
+    };
+    // A thread enqueues `mine` and spins on `pred`; on unlock it
+    // recycles its predecessor's node as its next `mine`.
+    struct Node {
+        QNode* mine = nullptr;
+        QNode* pred = nullptr;
+    };
+    alignas(64) std::atomic<QNode*> tail{nullptr};
+    std::vector<std::unique_ptr<QNode>> storage;
+
+    ClhLock() {
+        storage.push_back(std::make_unique<QNode>());
+        tail.store(storage.back().get(), std::memory_order_relaxed);
+    }
+    void init_node(Node& n) {
+        storage.push_back(std::make_unique<QNode>());
+        n.mine = storage.back().get();
+    }
+    void lock(Node& n) {
+        n.mine->locked.store(true, std::memory_order_relaxed);
+        n.pred = tail.exchange(n.mine, std::memory_order_acq_rel);
+        while (n.pred->locked.load(std::memory_order_acquire)) cpu_relax();
+    }
+    void unlock(Node& n) {
+        n.mine->locked.store(false, std::memory_order_release);
+        n.mine = n.pred;
+    }
+};
+
+template <int Kind>
+struct PthreadLock {
+    // Kind: 0 normal, 1 adaptive, 2 priority-inheritance
+    static constexpr const char* name = Kind == 0 ? "pthread" : Kind == 1 ? "adaptive" : "pi";
+    using Node = Empty;
+    pthread_mutex_t m;
+
+    PthreadLock() {
+        pthread_mutexattr_t a;
+        pthread_mutexattr_init(&a);
+        if constexpr (Kind == 0) pthread_mutexattr_settype(&a, PTHREAD_MUTEX_NORMAL);
+        if constexpr (Kind == 1) pthread_mutexattr_settype(&a, PTHREAD_MUTEX_ADAPTIVE_NP);
+        if constexpr (Kind == 2) pthread_mutexattr_setprotocol(&a, PTHREAD_PRIO_INHERIT);
+        pthread_mutex_init(&m, &a);
+        pthread_mutexattr_destroy(&a);
+    }
+    ~PthreadLock() { pthread_mutex_destroy(&m); }
+
+    void init_node(Node&) {}
+    void lock(Node&)   { pthread_mutex_lock(&m); }
+    void unlock(Node&) { pthread_mutex_unlock(&m); }
+};
+
+// ------------------------------------------------------------
+// Runner
+// ------------------------------------------------------------
+
+struct Config {
+    double seconds = 0.3;
+    int    ncs_iters = 200; // work between unlock and next lock()
+};
+
+// Protected by the lock under test.
+struct alignas(64) HandoffState {
+    int     last_owner = -1;
+    int64_t release_ns = 0;
+};
+
+static inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static inline uint64_t spin_work(int iters, uint64_t x) {
+    for (int i = 0; i < iters; i++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        asm volatile("" : "+r"(x));
+    }
+    return x;
+}
+
+// One line per thread: count and the vector ends are written inside the
+// critical section, and sharing them would add traffic to the handoff.
+struct alignas(64) ThreadResult {
+    std::vector<uint64_t> acquire;
+    std::vector<uint64_t> handoff;
+    uint64_t count = 0;
+    uint64_t acc = 0; // spin_work result; folded into sink after join
+};
+
+template <typename Lock>
+static void run_cell(int threads, int cs_iters, const Config& cfg) {
+    Lock lock;
+    HandoffState st;
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::vector<ThreadResult> res(threads);
+    std::vector<typename Lock::Node> nodes(threads);
+    for (auto& n : nodes) lock.init_node(n);
+
+    const size_t cap = 2'000'000;
+    std::vector<std::thread> ts;
+    for (int t = 0; t < threads; t++) {
+        ts.emplace_back([&, t] {
+            pin_to(t);
+            ThreadResult& r = res[t];
+            r.acquire.reserve(cap);
+            r.handoff.reserve(cap);
+            auto& node = nodes[t];
+            uint64_t x = (uint64_t)t;
+            while (!start.load(std::memory_order_acquire)) {}
+            while (!stop.load(std::memory_order_relaxed)) {
+                const int64_t t_req = now_ns();
+                lock.lock(node);
+                const int64_t t_acq = now_ns();
+
+                // Inside the critical section: read who released it and when.
+                if (st.last_owner >= 0 && st.last_owner != t && t_req < st.release_ns &&
+                    r.handoff.size() < cap) {
+                    r.handoff.push_back((uint64_t)(t_acq - st.release_ns));
+                }
+                x = spin_work(cs_iters, x);
+                st.last_owner = t;
+                st.release_ns = now_ns();
+                lock.unlock(node);
+
+                if (r.acquire.size() < cap) r.acquire.push_back((uint64_t)(t_acq - t_req));
+                r.count++;
+                x = spin_work(cfg.ncs_iters, x);
+            }
+            r.acc = x;
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& th : ts) th.join();
+
+    std::vector<uint64_t> acq, hand;
+    uint64_t total = 0, mn = UINT64_MAX, mx = 0;
+    for (auto& r : res) {
+        acq.insert(acq.end(), r.acquire.begin(), r.acquire.end());
+        hand.insert(hand.end(), r.handoff.begin(), r.handoff.end());
+        total += r.count;
+        sink = sink + r.acc;
+        mn = std::min(mn, r.count);
+        mx = std::max(mx, r.count);
+    }
+    const lat::Stats a = lat::compute_stats(std::move(acq));
+    const lat::Stats h = lat::compute_stats(std::move(hand));
+    std::printf("%-9s %3d %5d | %6llu %7llu %8llu %9llu | %6llu %7llu %8llu %9llu | %9.2f %5.2f\n",
+                Lock::name, threads, cs_iters,
+                (unsigned long long)a.p50, (unsigned long long)a.p99,
+                (unsigned long long)a.p999, (unsigned long long)a.max,
+                (unsigned long long)h.p50, (unsigned long long)h.p99,
+                (unsigned long long)h.p999, (unsigned long long)h.max,
+                (double)total / cfg.seconds / 1e6,
+                mx ? (double)mn / (double)mx : 0.0);
+}
+
+template <typename Lock>
+static void run_lock(const std::vector<int>& levels, const std::vector<int>& cs, const Config& cfg) {
+    for (int t : levels) {
+        for (int c : cs) run_cell<Lock>(t, c, cfg);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int ncpu = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    int max_threads = std::max(2, ncpu);
+    Config cfg;
+    std::vector<int> cs = {0, 100, 1000};
+    std::string only;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--max-threads=", 0) == 0) max_threads = std::max(1, std::atoi(a.c_str() + 14));
+        else if (a.rfind("--seconds=", 0) == 0) cfg.seconds = std::max(0.05, std::atof(a.c_str() + 10));
+        else if (a.rfind("--cs=", 0) == 0) cs = {std::max(0, std::atoi(a.c_str() + 5))};
+        else if (a.rfind("--ncs=", 0) == 0) cfg.ncs_iters = std::max(0, std::atoi(a.c_str() + 6));
+        else only = a;
+    }
+
+    std::vector<int> levels;
+    for (int t = 1; t < max_threads; t *= 2) levels.push_back(t);
+    levels.push_back(max_threads);
+
+    std::printf("Lock acquire / handoff latency (ns), %d CPUs online, %.2fs per cell\n", ncpu, cfg.seconds);
+    if (max_threads > ncpu) {
+        std::printf("NOTE: up to %d threads on %d CPUs: spinning waiters can burn the holder's time slice.\n",
+                    max_threads, ncpu);
+    }
+    std::printf("cs / ncs = LCG iterations inside / outside the critical section (ncs=%d)\n", cfg.ncs_iters);
+    std::printf("%-9s %3s %5s | %6s %7s %8s %9s | %6s %7s %8s %9s | %9s %5s\n",
+                "lock", "thr", "cs", "acq50", "acq99", "acq99.9", "acqmax",
+                "hnd50", "hnd99", "hnd99.9", "hndmax", "Macq/s", "fair");
+
+    auto want = [&](const char* n) { return only.empty() || only == n; };
+    if (want(TasLock::name))           run_lock<TasLock>(levels, cs, cfg);
+    if (want(TtasLock::name))          run_lock<TtasLock>(levels, cs, cfg);
+    if (want(TicketLock::name))        run_lock<TicketLock>(levels, cs, cfg);
+    if (want(McsLock::name))           run_lock<McsLock>(levels, cs, cfg);
+    if (want(ClhLock::name))           run_lock<ClhLock>(levels, cs, cfg);
+    if (want(PthreadLock<0>::name))    run_lock<PthreadLock<0>>(levels, cs, cfg);
+    if (want(PthreadLock<1>::name))    run_lock<PthreadLock<1>>(levels, cs, cfg);
+    if (want(PthreadLock<2>::name))    run_lock<PthreadLock<2>>(levels, cs, cfg);
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  fair = min/max acquisitions per thread (1.00 = perfectly fair).\n");
+    std::printf("  Spin locks win the handoff p50; look at p99.9/max and fair before choosing one.\n");
+    std::printf("  Futex-based mutexes trade a wakeup on every contended handoff for not burning CPU.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
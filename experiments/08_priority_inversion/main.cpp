@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// Classic priority inversion, reproduced on purpose:
+//
+//   LOW    (SCHED_FIFO 10) takes the lock and works for CS_US
+//   HIGH   (SCHED_FIFO 30) wakes 100 us later and wants the lock
+//   MEDIUM (SCHED_FIFO 20) wakes 200 us later and burns BURN_US of CPU
+//
+// All three share ONE CPU. Timeline per trial:
+//
+//   normal mutex:  HIGH blocks on LOW. MEDIUM preempts LOW (20 > 10)
+//                  and burns its whole budget. LOW finishes only after
+//                  that, so HIGH waits ~ BURN_US + rest of CS_US.
+//                  A medium-priority thread delayed a high-priority one.
+//
+//   PI mutex:      when HIGH blocks, the kernel boosts LOW to 30.
+//                  MEDIUM cannot preempt it; HIGH waits only for the
+//                  rest of CS_US.
+//
+// We measure HIGH's lock-acquire latency over many trials.
+//
+// Needs SCHED_FIFO: run as root or with an RLIMIT_RTPRIO >= 30.
+// ------------------------------------------------------------
+
+constexpr int PRIO_LOW    = 10;
+constexpr int PRIO_MEDIUM = 20;
+constexpr int PRIO_HIGH   = 30;
+
+constexpr int64_t HIGH_DELAY_NS   = 100'000;
+constexpr int64_t MEDIUM_DELAY_NS = 200'000;
+
+struct Config {
+    int     cpu = 0;
+    int     trials = 100;
+    int64_t cs_ns = 1'000'000;   // LOW's critical section
+    int64_t burn_ns = 5'000'000; // MEDIUM's CPU burn
+    int64_t period_ns = 0;       // derived: room for everything + idle gap
+};
+
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+static void sleep_until(int64_t t) {
+    timespec ts;
+    ts.tv_sec = t / 1'000'000'000;
+    ts.tv_nsec = t % 1'000'000'000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+// Busy-work for `ns` of this thread's CPU time, so preemption
+// stretches it instead of shortening it (that is the whole point).
+static void burn_cpu(int64_t ns) {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    const int64_t start = (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+    for (;;) {
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        if ((int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec - start >= ns) return;
+    }
+}
+
+struct Shared {
+    pthread_mutex_t m;
+    Config cfg;
+    int64_t start_ns = 0;
+    std::vector<uint64_t> high_wait;
+    std::atomic<int> setup_failed{0};
+};
+
+struct Role {
+    Shared* sh;
+    int prio;
+    int which; // 0 low, 1 medium, 2 high
+};
+
+static bool make_rt(int prio, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return false;
+    sched_param sp{};
+    sp.sched_priority = prio;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0;
+}
+
+static void* role_main(void* arg) {
+    Role* r = static_cast<Role*>(arg);
+    Shared& sh = *r->sh;
+    if (!make_rt(r->prio, sh.cfg.cpu)) {
+        sh.setup_failed.store(1);
+        return nullptr;
+    }
+
+    for (int t = 0; t < sh.cfg.trials; t++) {
+        const int64_t base = sh.start_ns + (int64_t)t * sh.cfg.period_ns;
+        if (r->which == 0) {
+            sleep_until(base);
+            pthread_mutex_lock(&sh.m);
+            burn_cpu(sh.cfg.cs_ns);
+            pthread_mutex_unlock(&sh.m);
+        } else if (r->which == 1) {
+            sleep_until(base + MEDIUM_DELAY_NS);
+            burn_cpu(sh.cfg.burn_ns);
+        } else {
+            sleep_until(base + HIGH_DELAY_NS);
+            const int64_t t_req = now_ns();
+            pthread_mutex_lock(&sh.m);
+            const int64_t t_acq = now_ns();
+            pthread_mutex_unlock(&sh.m);
+            sh.high_wait.push_back((uint64_t)(t_acq - t_req));
+        }
+    }
+    return nullptr;
+}
+
+static bool run_variant(const char* label, int protocol, const Config& cfg) {
+    Shared sh;
+    sh.cfg = cfg;
+    sh.high_wait.reserve(cfg.trials);
+
+    pthread_mutexattr_t a;
+    pthread_mutexattr_init(&a);
+    pthread_mutexattr_setprotocol(&a, protocol);
+    pthread_mutex_init(&sh.m, &a);
+    pthread_mutexattr_destroy(&a);
+
+    // First trial starts a little in the future so all threads are parked.
+    sh.start_ns = now_ns() + 50'000'000;
+
+    Role roles[3] = {{&sh, PRIO_LOW, 0}, {&sh, PRIO_MEDIUM, 1}, {&sh, PRIO_HIGH, 2}};
+    pthread_t th[3];
+    for (int i = 0; i < 3; i++) pthread_create(&th[i], nullptr, role_main, &roles[i]);
+    for (int i = 0; i < 3; i++) pthread_join(th[i], nullptr);
+    pthread_mutex_destroy(&sh.m);
+
+    if (sh.setup_failed.load()) return false;
+
+    // Convert to microseconds for readability.
+    std::vector<uint64_t> us;
+    us.reserve(sh.high_wait.size());
+    for (uint64_t ns : sh.high_wait) us.push_back(ns / 1000);
+    const lat::Stats s = lat::compute_stats(std::move(us));
+    std::printf("%-16s %6zu %8llu %9.1f %8llu %8llu %8llu %8llu\n",
+                label, s.n, (unsigned long long)s.min, s.avg,
+                (unsigned long long)s.p50, (unsigned long long)s.p99,
+                (unsigned long long)s.p999, (unsigned long long)s.max);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--cpu=", 0) == 0)         cfg.cpu = std::max(0, std::atoi(a.c_str() + 6));
+        else if (a.rfind("--trials=", 0) == 0) cfg.trials = std::max(1, std::atoi(a.c_str() + 9));
+        else if (a.rfind("--cs-us=", 0) == 0)  cfg.cs_ns = std::max(1L, std::atol(a.c_str() + 8)) * 1000;
+        else if (a.rfind("--burn-us=", 0) == 0) cfg.burn_ns = std::max(1L, std::atol(a.c_str() + 10)) * 1000;
+    }
+    // Everything fits in a period, then at least as long idle again,
+    // which also keeps us far from the RT throttling budget (95%).
+    cfg.period_ns = 2 * (cfg.cs_ns + cfg.burn_ns + MEDIUM_DELAY_NS);
+
+    // Page faults inside an RT section would muddy the picture.
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::printf("NOTE: mlockall failed (%s); continuing.\n", std::strerror(errno));
+    }
+
+    std::printf("Priority inversion: LOW(FIFO %d) holds lock %ld us, HIGH(FIFO %d) wants it at +%ld us,\n",
+                PRIO_LOW, (long)(cfg.cs_ns / 1000), PRIO_HIGH, (long)(HIGH_DELAY_NS / 1000));
+    std::printf("MEDIUM(FIFO %d) burns %ld us from +%ld us. All on CPU %d, %d trials.\n",
+                PRIO_MEDIUM, (long)(cfg.burn_ns / 1000), (long)(MEDIUM_DELAY_NS / 1000),
+                cfg.cpu, cfg.trials);
+    std::printf("HIGH lock-acquire latency (us)\n");
+    std::printf("%-16s %6s %8s %9s %8s %8s %8s %8s\n",
+                "mutex", "n", "min", "avg", "p50", "p99", "p99.9", "max");
+
+    if (!run_variant("normal", PTHREAD_PRIO_NONE, cfg) ||
+        !run_variant("PRIO_INHERIT", PTHREAD_PRIO_INHERIT, cfg)) {
+        std::fprintf(stderr, "Could not set SCHED_FIFO / affinity for CPU %d.\n"
+                             "Run as root, or raise RLIMIT_RTPRIO (ulimit -r %d).\n",
+                     cfg.cpu, PRIO_HIGH);
+        return 1;
+    }
+
+    const long expect_normal = (long)((cfg.burn_ns + cfg.cs_ns - HIGH_DELAY_NS) / 1000);
+    const long expect_pi = (long)((cfg.cs_ns - HIGH_DELAY_NS) / 1000);
+    std::printf("\nExpected: normal ~%ld us (MEDIUM's burn + rest of LOW's section),\n", expect_normal);
+    std::printf("          PRIO_INHERIT ~%ld us (rest of LOW's section only).\n", expect_pi);
+    return 0;
+}
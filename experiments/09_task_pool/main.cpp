@@ -0,0 +1,522 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "../common/stats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// A strategy fans out into K independent tasks on a thread pool.
+// How long does a task wait before a worker STARTS it, and how long
+// until the whole fan-out is done?
+//
+// Each batch:
+//   submitter --(external submit)--> root task
+//   root task --(spawn x K)--------> child tasks, each busy for WORK ns
+//   last child to finish records "done" and wakes the submitter
+//
+// Then the submitter sleeps GAP us so the workers go idle again:
+// we measure dispatch from idle, the case a reactive system lives in.
+//
+// Pools:
+//   steal   per-worker Chase-Lev deques; the owner pops LIFO, idle
+//           workers steal FIFO from the others; external submits go
+//           through a small mutex-protected injector queue
+//   mutex   one std::deque behind one mutex, shared by everyone
+//   async   std::async(std::launch::async): a new thread per task
+//
+// Idle strategies (steal / mutex):
+//   spin    re-check the queues with pause
+//   yield   re-check, sched_yield() in between
+//   park    spin briefly, then sleep on a condition variable;
+//           every spawn wakes one sleeper
+//
+// Metrics (ns):
+//   root    submit -> root task starts (external dispatch)
+//   start   spawn  -> child task starts (internal dispatch)
+//   done    submit -> last child finished (fan-out completion)
+//
+// THEORY:
+// - spin has the best p50 and burns a core per idle worker; with more
+//   workers than CPUs it starves the very thread holding the work.
+// - park costs a futex wakeup (microseconds) per idle worker woken.
+// - a single mutex queue serializes every push and pop; stealing
+//   keeps the owner's push/pop uncontended and only thieves pay.
+// - std::async pays thread creation per task: tens of microseconds.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Returns its result instead of writing sink: every worker writing one
+// global would race, and the line bouncing between them would be timed.
+static uint64_t busy_for(int64_t ns) {
+    const int64_t end = now_ns() + ns;
+    uint64_t x = 1;
+    while (now_ns() < end) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        asm volatile("" : "+r"(x));
+    }
+    return x;
+}
+
+// ------------------------------------------------------------
+// Tasks
+// ------------------------------------------------------------
+
+struct Batch;
+
+struct Task {
+    Batch*  batch = nullptr;
+    bool    root = false;
+    int64_t t_ready = 0; // submit (root) or spawn (child) time
+};
+
+struct Batch {
+    Task                 root_task;
+    std::vector<Task>    children;
+    std::atomic<int>     remaining{0};
+    std::atomic<bool>    done{false};
+    int64_t              t_done = 0;
+
+    std::vector<uint64_t> root_lat;
+    std::vector<uint64_t> start_lat;
+    std::vector<uint64_t> done_lat;
+};
+
+// ------------------------------------------------------------
+// Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli,
+// "Correct and Efficient Work-Stealing for Weak Memory Models", 2013),
+// fixed capacity: push() fails instead of growing.
+// ------------------------------------------------------------
+
+class ChaseLevDeque {
+public:
+    static constexpr int64_t CAP = 1024;
+
+    bool push(Task* t) {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t tp = top_.load(std::memory_order_acquire);
+        if (b - tp >= CAP) return false;
+        buf_[b & (CAP - 1)].store(t, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only.
+    Task* pop() {
+        const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t tp = top_.load(std::memory_order_relaxed);
+        Task* t = nullptr;
+        if (tp <= b) {
+            t = buf_[b & (CAP - 1)].load(std::memory_order_relaxed);
+            if (tp == b) {
+                // Last element: race the thieves for it.
+                if (!top_.compare_exchange_strong(tp, tp + 1, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    t = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    // Any thread.
+    Task* steal() {
+        int64_t tp = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        if (tp >= b) return nullptr;
+        Task* t = buf_[tp & (CAP - 1)].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(tp, tp + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr; // lost the race; caller moves on
+        }
+        return t;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    alignas(64) std::atomic<Task*>   buf_[CAP];
+};
+
+// ------------------------------------------------------------
+// Pools: push_external(), push_local(worker), get(worker).
+// ------------------------------------------------------------
+
+struct StealPool {
+    static constexpr const char* name = "steal";
+
+    struct alignas(64) Worker {
+        ChaseLevDeque dq;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex         inj_m;
+    std::deque<Task*>  injector;
+
+    explicit StealPool(int n) {
+        for (int i = 0; i < n; i++) workers.push_back(std::make_unique<Worker>());
+    }
+
+    void push_external(Task* t) {
+        std::lock_guard<std::mutex> g(inj_m);
+        injector.push_back(t);
+    }
+
+    void push_local(int w, Task* t) {
+        if (!workers[w]->dq.push(t)) push_external(t);
+    }
+
+    Task* get(int w) {
+        if (Task* t = workers[w]->dq.pop()) return t;
+        const int n = (int)workers.size();
+        for (int k = 1; k < n; k++) {
+            if (Task* t = workers[(w + k) % n]->dq.steal()) return t;
+        }
+        std::lock_guard<std::mutex> g(inj_m);
+        if (injector.empty()) return nullptr;
+        Task* t = injector.front();
+        injector.pop_front();
+        return t;
+    }
+};
+
+struct MutexPool {
+    static constexpr const char* name = "mutex";
+
+    std::mutex        m;
+    std::deque<Task*> q;
+
+    explicit MutexPool(int) {}
+
+    void push_external(Task* t) {
+        std::lock_guard<std::mutex> g(m);
+        q.push_back(t);
+    }
+
+    void push_local(int, Task* t) { push_external(t); }
+
+    Task* get(int) {
+        std::lock_guard<std::mutex> g(m);
+        if (q.empty()) return nullptr;
+        Task* t = q.front();
+        q.pop_front();
+        return t;
+    }
+};
+
+// ------------------------------------------------------------
+// Idle strategies
+// ------------------------------------------------------------
+
+enum class Idle { Spin, Yield, Park };
+
+static const char* idle_name(Idle i) {
+    switch (i) {
+        case Idle::Spin:  return "spin";
+        case Idle::Yield: return "yield";
+        case Idle::Park:  return "park";
+    }
+    return "?";
+}
+
+// Sleepers wait for `epoch` to move. A pusher bumps epoch AFTER
+// publishing the task and only takes the lock if someone sleeps;
+// a sleeper registers BEFORE its last look at the queues. Both sides
+// are seq_cst, so at least one of them sees the other.
+struct Parker {
+    std::atomic<uint64_t>   epoch{0};
+    std::atomic<int>        sleepers{0};
+    std::mutex              m;
+    std::condition_variable cv;
+
+    void notify_one() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> g(m);
+            cv.notify_one();
+        }
+    }
+
+    void notify_all() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> g(m);
+        cv.notify_all();
+    }
+};
+
+constexpr int SPINS_BEFORE_PARK = 2000;
+
+// ------------------------------------------------------------
+// Runner
+// ------------------------------------------------------------
+
+struct Config {
+    int     workers = 2;
+    int     fanout = 8;
+    int     batches = 2000;
+    int64_t work_ns = 2000;
+    int64_t gap_us = 100;
+};
+
+template <typename Pool>
+struct Runner {
+    Pool              pool;
+    Parker            parker;
+    Idle              idle;
+    std::atomic<bool> stop{false};
+
+    // busy_for() results, one line per worker; folded into sink after join.
+    struct alignas(64) WorkerAcc {
+        uint64_t v = 0;
+    };
+    std::vector<WorkerAcc> acc;
+
+    Runner(int workers, Idle i) : pool(workers), idle(i), acc(workers) {}
+
+    void spawn(int w, Task* t) {
+        t->t_ready = now_ns();
+        pool.push_local(w, t);
+        if (idle == Idle::Park) parker.notify_one();
+    }
+
+    void submit(Task* t) {
+        t->t_ready = now_ns();
+        pool.push_external(t);
+        if (idle == Idle::Park) parker.notify_one();
+    }
+
+    void run_task(int w, Task* t, const Config& cfg) {
+        const int64_t t_start = now_ns();
+        Batch& b = *t->batch;
+        if (t->root) {
+            b.root_lat.push_back((uint64_t)(t_start - t->t_ready));
+            for (Task& c : b.children) spawn(w, &c);
+            return;
+        }
+        // Children write disjoint slots, so no lock: index by position.
+        b.start_lat[(size_t)(t - b.children.data())] = (uint64_t)(t_start - t->t_ready);
+        acc[w].v += busy_for(cfg.work_ns);
+        if (b.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            b.t_done = now_ns();
+            b.done.store(true, std::memory_order_release);
+            b.done.notify_one();
+        }
+    }
+
+    Task* wait_for_task(int w) {
+        int spins = 0;
+        for (;;) {
+            if (Task* t = pool.get(w)) return t;
+            if (stop.load(std::memory_order_relaxed)) return nullptr;
+            if (idle == Idle::Spin) {
+                cpu_relax();
+            } else if (idle == Idle::Yield) {
+                sched_yield();
+            } else if (++spins < SPINS_BEFORE_PARK) {
+                cpu_relax();
+            } else {
+                const uint64_t e = parker.epoch.load(std::memory_order_seq_cst);
+                parker.sleepers.fetch_add(1, std::memory_order_seq_cst);
+                if (Task* t = pool.get(w)) {
+                    parker.sleepers.fetch_sub(1, std::memory_order_relaxed);
+                    return t;
+                }
+                {
+                    std::unique_lock<std::mutex> lk(parker.m);
+                    parker.cv.wait(lk, [&] {
+                        return parker.epoch.load(std::memory_order_seq_cst) != e ||
+                               stop.load(std::memory_order_relaxed);
+                    });
+                }
+                parker.sleepers.fetch_sub(1, std::memory_order_relaxed);
+                spins = 0;
+            }
+        }
+    }
+};
+
+static void print_rows(const std::string& label, Batch& b) {
+    lat::print_table_row(label + " root",  lat::compute_stats(std::move(b.root_lat)), 22);
+    lat::print_table_row(label + " start", lat::compute_stats(std::move(b.start_lat)), 22);
+    lat::print_table_row(label + " done",  lat::compute_stats(std::move(b.done_lat)), 22);
+}
+
+static void reset_batch(Batch& b, int fanout) {
+    b.remaining.store(fanout, std::memory_order_relaxed);
+    b.done.store(false, std::memory_order_relaxed);
+}
+
+template <typename Pool>
+static void run_pool(Idle idle, const Config& cfg) {
+    Runner<Pool> r(cfg.workers, idle);
+
+    Batch b;
+    b.root_task.batch = &b;
+    b.root_task.root = true;
+    b.children.resize(cfg.fanout);
+    for (Task& c : b.children) c.batch = &b;
+    b.root_lat.reserve(cfg.batches);
+    b.done_lat.reserve(cfg.batches);
+
+    std::vector<uint64_t> all_start;
+    all_start.reserve((size_t)cfg.batches * cfg.fanout);
+    b.start_lat.assign(cfg.fanout, 0);
+
+    std::vector<std::thread> ws;
+    for (int w = 0; w < cfg.workers; w++) {
+        ws.emplace_back([&, w] {
+            pin_to(w);
+            while (Task* t = r.wait_for_task(w)) r.run_task(w, t, cfg);
+        });
+    }
+
+    for (int i = 0; i < cfg.batches; i++) {
+        reset_batch(b, cfg.fanout);
+        const int64_t t_submit = now_ns();
+        r.submit(&b.root_task);
+        b.done.wait(false, std::memory_order_acquire);
+        b.done_lat.push_back((uint64_t)(b.t_done - t_submit));
+        all_start.insert(all_start.end(), b.start_lat.begin(), b.start_lat.end());
+        std::this_thread::sleep_for(std::chrono::microseconds(cfg.gap_us));
+    }
+
+    r.stop.store(true, std::memory_order_relaxed);
+    r.parker.notify_all();
+    for (auto& th : ws) th.join();
+    for (const auto& a : r.acc) sink = sink + a.v;
+
+    b.start_lat = std::move(all_start);
+    print_rows(std::string(Pool::name) + "/" + idle_name(idle), b);
+}
+
+static void run_async(const Config& cfg) {
+    Batch b;
+    b.root_lat.reserve(cfg.batches);
+    b.done_lat.reserve(cfg.batches);
+    b.start_lat.reserve((size_t)cfg.batches * cfg.fanout);
+    std::vector<int64_t> child_start(cfg.fanout);
+    uint64_t acc = 0; // written by each root thread, read after root.get()
+
+    for (int i = 0; i < cfg.batches; i++) {
+        const int64_t t_submit = now_ns();
+        auto root = std::async(std::launch::async, [&] {
+            b.root_lat.push_back((uint64_t)(now_ns() - t_submit));
+            std::vector<std::future<uint64_t>> fs;
+            fs.reserve(cfg.fanout);
+            for (int k = 0; k < cfg.fanout; k++) {
+                const int64_t t_spawn = now_ns();
+                fs.push_back(std::async(std::launch::async, [&, k, t_spawn] {
+                    child_start[k] = now_ns() - t_spawn;
+                    return busy_for(cfg.work_ns);
+                }));
+            }
+            for (auto& f : fs) acc += f.get();
+            return now_ns();
+        });
+        const int64_t t_done = root.get();
+        b.done_lat.push_back((uint64_t)(t_done - t_submit));
+        for (int64_t s : child_start) b.start_lat.push_back((uint64_t)s);
+        std::this_thread::sleep_for(std::chrono::microseconds(cfg.gap_us));
+    }
+    sink = sink + acc;
+    print_rows("async", b);
+}
+
+int main(int argc, char** argv) {
+    const int ncpu = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    Config cfg;
+    cfg.workers = std::max(2, ncpu);
+    std::string only;
+    std::vector<Idle> idles = {Idle::Spin, Idle::Yield, Idle::Park};
+
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--workers=", 0) == 0)      cfg.workers = std::max(1, std::atoi(a.c_str() + 10));
+        else if (a.rfind("--fanout=", 0) == 0)  cfg.fanout = std::clamp(std::atoi(a.c_str() + 9), 1, 512);
+        else if (a.rfind("--batches=", 0) == 0) cfg.batches = std::max(1, std::atoi(a.c_str() + 10));
+        else if (a.rfind("--work-ns=", 0) == 0) cfg.work_ns = std::max(0L, std::atol(a.c_str() + 10));
+        else if (a.rfind("--gap-us=", 0) == 0)  cfg.gap_us = std::max(0L, std::atol(a.c_str() + 9));
+        else if (a.rfind("--idle=", 0) == 0) {
+            const std::string v = a.substr(7);
+            idles = {v == "spin" ? Idle::Spin : v == "yield" ? Idle::Yield : Idle::Park};
+        } else only = a;
+    }
+
+    std::printf("Task pool dispatch latency (ns): %d workers, fan-out %d, %lld ns per task,\n",
+                cfg.workers, cfg.fanout, (long long)cfg.work_ns);
+    std::printf("%d batches, %lld us idle gap between batches, %d CPUs online\n",
+                cfg.batches, (long long)cfg.gap_us, ncpu);
+    if (cfg.workers > ncpu) {
+        std::printf("NOTE: %d workers > %d CPUs: spinning idle workers steal time from busy ones.\n",
+                    cfg.workers, ncpu);
+    }
+    lat::print_table_header("pool/idle metric", 22);
+
+    auto want = [&](const char* n) { return only.empty() || only == n; };
+    if (want(StealPool::name)) {
+        for (Idle i : idles) run_pool<StealPool>(i, cfg);
+    }
+    if (want(MutexPool::name)) {
+        for (Idle i : idles) run_pool<MutexPool>(i, cfg);
+    }
+    if (want("async")) run_async(cfg);
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  root = submit -> root starts, start = spawn -> child starts,\n");
+    std::printf("  done = submit -> last child finished.\n");
+    std::printf("  Compare start p99.9 across idle strategies before comparing pools:\n");
+    std::printf("  how idle workers wait usually dominates how the queue is built.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
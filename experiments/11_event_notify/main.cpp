@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+#include "../common/uring.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// A producer thread posts one small event at a time; a consumer
+// thread waits for it. How long from write() to the consumer holding
+// the data, and how much CPU does the consumer burn while waiting?
+//
+// Channels:
+//   eventfd   8-byte counter
+//   pipe      8 bytes
+//   udp       8-byte datagram over 127.0.0.1
+//   tcp       8 bytes over a 127.0.0.1 connection (TCP_NODELAY)
+//
+// Consumers:
+//   epoll     epoll_wait(-1): sleep until ready, then read()
+//   busy      epoll_wait(0) in a loop: never sleeps, then read()
+//   sqpoll    io_uring with IORING_SETUP_SQPOLL: a READ is always in
+//             flight, the consumer spins on the CQ ring (no syscalls);
+//             a kernel thread polls the SQ
+//   mpoll     io_uring multishot POLL_ADD: one armed poll, the consumer
+//             blocks in io_uring_enter, then read()
+//
+// Latency (ns) = consumer has the bytes - producer's timestamp just
+// before write(). One event in flight; GAP us between events.
+//
+// CPU columns: consumer thread and whole process, as % of wall time.
+// The SQPOLL kernel thread belongs to the process, so it shows in
+// proc% but not in cons%.
+//
+// THEORY:
+// - a blocking wait costs a wakeup (scheduler, maybe an IPI and a
+//   C-state exit) but no CPU while idle.
+// - busy polling removes the wakeup and burns a whole core.
+// - SQPOLL moves the syscall into a kernel thread that also burns a
+//   core (until sq_thread_idle); multishot poll saves re-arming.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+static int64_t cpu_ns(int who) {
+    rusage ru;
+    getrusage(who, &ru);
+    return ((int64_t)ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1'000'000'000 +
+           ((int64_t)ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000;
+}
+
+// ------------------------------------------------------------
+// Channels: blocking fds, because io_uring returns -EAGAIN on
+// O_NONBLOCK files instead of waiting.
+// ------------------------------------------------------------
+
+enum class Chan { Eventfd, Pipe, Udp, Tcp };
+
+static const char* chan_name(Chan c) {
+    switch (c) {
+        case Chan::Eventfd: return "eventfd";
+        case Chan::Pipe:    return "pipe";
+        case Chan::Udp:     return "udp";
+        case Chan::Tcp:     return "tcp";
+    }
+    return "?";
+}
+
+struct Channel {
+    int rfd = -1;
+    int wfd = -1;
+    int extra = -1; // tcp listener
+
+    ~Channel() {
+        for (int fd : {rfd, wfd, extra}) {
+            if (fd >= 0) close(fd);
+        }
+    }
+};
+
+static bool open_channel(Chan c, Channel& ch) {
+    if (c == Chan::Eventfd) {
+        ch.rfd = eventfd(0, EFD_CLOEXEC);
+        ch.wfd = dup(ch.rfd);
+        return ch.rfd >= 0;
+    }
+    if (c == Chan::Pipe) {
+        int p[2];
+        if (pipe(p) != 0) return false;
+        ch.rfd = p[0];
+        ch.wfd = p[1];
+        return true;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+
+    if (c == Chan::Udp) {
+        ch.rfd = socket(AF_INET, SOCK_DGRAM, 0);
+        ch.wfd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (bind(ch.rfd, (sockaddr*)&addr, sizeof(addr)) != 0) return false;
+        getsockname(ch.rfd, (sockaddr*)&addr, &len);
+        return connect(ch.wfd, (sockaddr*)&addr, sizeof(addr)) == 0;
+    }
+
+    ch.extra = socket(AF_INET, SOCK_STREAM, 0);
+    if (bind(ch.extra, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(ch.extra, 1) != 0) return false;
+    getsockname(ch.extra, (sockaddr*)&addr, &len);
+    ch.wfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(ch.wfd, (sockaddr*)&addr, sizeof(addr)) != 0) return false;
+    ch.rfd = accept(ch.extra, nullptr, nullptr);
+    const int one = 1;
+    setsockopt(ch.wfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(ch.rfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return ch.rfd >= 0;
+}
+
+static bool read8(int fd, uint64_t& v) {
+    char* p = reinterpret_cast<char*>(&v);
+    size_t got = 0;
+    while (got < sizeof(v)) {
+        const ssize_t r = read(fd, p + got, sizeof(v) - got);
+        if (r <= 0) return false;
+        got += (size_t)r;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Consumers
+// ------------------------------------------------------------
+
+enum class Cons { Epoll, Busy, Sqpoll, Mpoll };
+
+static const char* cons_name(Cons c) {
+    switch (c) {
+        case Cons::Epoll:  return "epoll";
+        case Cons::Busy:   return "busy";
+        case Cons::Sqpoll: return "sqpoll";
+        case Cons::Mpoll:  return "mpoll";
+    }
+    return "?";
+}
+
+struct Config {
+    int     events = 2000;
+    int64_t gap_us = 100;
+};
+
+struct Shared {
+    std::atomic<int64_t>  sent_ns{0};
+    std::atomic<uint64_t> handled{0};
+    std::vector<uint64_t> lat;
+    int64_t               cons_cpu_ns = 0;
+    std::string           error;
+};
+
+static inline void got_event(Shared& sh) {
+    sh.lat.push_back((uint64_t)(now_ns() - sh.sent_ns.load(std::memory_order_acquire)));
+    sh.handled.fetch_add(1, std::memory_order_release);
+}
+
+static void consume_epoll(int fd, bool busy, Shared& sh, int n) {
+    const int ep = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+    uint64_t v = 0;
+    while ((int)sh.lat.size() < n) {
+        epoll_event out;
+        if (epoll_wait(ep, &out, 1, busy ? 0 : -1) != 1) continue;
+        if (!read8(fd, v)) break;
+        got_event(sh);
+    }
+    sink = sink + v;
+    close(ep);
+}
+
+static void consume_sqpoll(int fd, Shared& sh, int n) {
+    lat::Uring ring;
+    if (const int e = ring.init(8, IORING_SETUP_SQPOLL, 1000); e < 0) {
+        sh.error = std::string("io_uring SQPOLL: ") + std::strerror(-e);
+        return;
+    }
+    uint64_t buf = 0;
+    auto arm = [&] {
+        io_uring_sqe* sqe = ring.get_sqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)&buf;
+        sqe->len = sizeof(buf);
+        ring.submit();
+    };
+    arm();
+    while ((int)sh.lat.size() < n) {
+        io_uring_cqe* cqe = ring.peek_cqe();
+        if (!cqe) continue; // spin on the CQ ring: no syscall
+        const int res = cqe->res;
+        ring.cqe_seen();
+        if (res < 0) {
+            sh.error = std::string("io_uring READ: ") + std::strerror(-res);
+            return;
+        }
+        got_event(sh);
+        if ((int)sh.lat.size() < n) arm();
+    }
+    sink = sink + buf;
+}
+
+static void consume_mpoll(int fd, Shared& sh, int n) {
+    lat::Uring ring;
+    if (const int e = ring.init(8); e < 0) {
+        sh.error = std::string("io_uring: ") + std::strerror(-e);
+        return;
+    }
+    io_uring_sqe* sqe = ring.get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    ring.submit();
+
+    uint64_t v = 0;
+    while ((int)sh.lat.size() < n) {
+        io_uring_cqe* cqe = ring.wait_cqe();
+        if (!cqe) break;
+        const int res = cqe->res;
+        const bool more = cqe->flags & IORING_CQE_F_MORE;
+        ring.cqe_seen();
+        if (res < 0) {
+            sh.error = std::string("io_uring POLL_ADD: ") + std::strerror(-res);
+            return;
+        }
+        if (!read8(fd, v)) break;
+        got_event(sh);
+        if (!more) { // the kernel dropped the multishot poll (e.g. CQ overflow): re-arm
+            sqe = ring.get_sqe();
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = fd;
+            sqe->poll32_events = POLLIN;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            ring.submit();
+        }
+    }
+    sink = sink + v;
+}
+
+static void run_cell(Chan c, Cons k, const Config& cfg) {
+    Channel ch;
+    char label[32];
+    std::snprintf(label, sizeof(label), "%s / %s", chan_name(c), cons_name(k));
+    if (!open_channel(c, ch)) {
+        std::printf("%-18s  (channel setup failed: %s)\n", label, std::strerror(errno));
+        return;
+    }
+
+    Shared sh;
+    sh.lat.reserve(cfg.events);
+    std::atomic<bool> consumer_done{false};
+
+    const int64_t wall0 = now_ns();
+    const int64_t proc0 = cpu_ns(RUSAGE_SELF);
+
+    std::thread consumer([&] {
+        pin_to(0);
+        const int64_t c0 = cpu_ns(RUSAGE_THREAD);
+        switch (k) {
+            case Cons::Epoll:  consume_epoll(ch.rfd, false, sh, cfg.events); break;
+            case Cons::Busy:   consume_epoll(ch.rfd, true, sh, cfg.events); break;
+            case Cons::Sqpoll: consume_sqpoll(ch.rfd, sh, cfg.events); break;
+            case Cons::Mpoll:  consume_mpoll(ch.rfd, sh, cfg.events); break;
+        }
+        sh.cons_cpu_ns = cpu_ns(RUSAGE_THREAD) - c0;
+        consumer_done.store(true, std::memory_order_release);
+    });
+
+    pin_to(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10)); // let the consumer arm
+    const uint64_t one = 1;
+    for (int i = 0; i < cfg.events && !consumer_done.load(std::memory_order_acquire); i++) {
+        sh.sent_ns.store(now_ns(), std::memory_order_release);
+        if (write(ch.wfd, &one, sizeof(one)) != (ssize_t)sizeof(one)) break;
+        while (sh.handled.load(std::memory_order_acquire) <= (uint64_t)i &&
+               !consumer_done.load(std::memory_order_acquire)) {
+            sched_yield();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(cfg.gap_us));
+    }
+    consumer.join();
+
+    const double wall = (double)(now_ns() - wall0);
+    const double proc = (double)(cpu_ns(RUSAGE_SELF) - proc0);
+    if (!sh.error.empty()) {
+        std::printf("%-18s  (%s)\n", label, sh.error.c_str());
+        return;
+    }
+    const lat::Stats s = lat::compute_stats(std::move(sh.lat));
+    std::printf("%-18s %6zu %8llu %8llu %8llu %9llu %10llu %7.1f %7.1f\n",
+                label, s.n, (unsigned long long)s.min, (unsigned long long)s.p50,
+                (unsigned long long)s.p99, (unsigned long long)s.p999,
+                (unsigned long long)s.max,
+                100.0 * (double)sh.cons_cpu_ns / wall, 100.0 * proc / wall);
+}
+
+int main(int argc, char** argv) {
+    const int ncpu = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    Config cfg;
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--events=", 0) == 0)      cfg.events = std::max(1, std::atoi(a.c_str() + 9));
+        else if (a.rfind("--gap-us=", 0) == 0) cfg.gap_us = std::max(0L, std::atol(a.c_str() + 9));
+        else only = a;
+    }
+
+    std::printf("Event notification latency (ns): producer on CPU 1, consumer on CPU 0\n");
+    std::printf("%d events per row, one in flight, %lld us gap; %d CPUs online\n",
+                cfg.events, (long long)cfg.gap_us, ncpu);
+    if (ncpu < 2) {
+        std::printf("NOTE: 1 CPU: busy / sqpoll consumers share it with the producer;\n"
+                    "      their latency includes waiting for a time slice.\n");
+    }
+    std::printf("%-18s %6s %8s %8s %8s %9s %10s %7s %7s\n",
+                "channel / consumer", "n", "min", "p50", "p99", "p99.9", "max", "cons%", "proc%");
+
+    const Chan chans[] = {Chan::Eventfd, Chan::Pipe, Chan::Udp, Chan::Tcp};
+    const Cons conss[] = {Cons::Epoll, Cons::Busy, Cons::Sqpoll, Cons::Mpoll};
+    for (Chan c : chans) {
+        for (Cons k : conss) {
+            if (!only.empty() && only != chan_name(c) && only != cons_name(k)) continue;
+            run_cell(c, k, cfg);
+        }
+    }
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  epoll / mpoll sleep: ~0%% CPU, a wakeup in every sample.\n");
+    std::printf("  busy / sqpoll never sleep: lower latency for a core (proc%% shows the SQPOLL thread).\n");
+    std::printf("  The channel matters less than the wait strategy, until the socket stack dominates.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
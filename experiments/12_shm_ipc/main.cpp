@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "../common/stats.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// Two PROCESSES (fault isolation), pinned to different CPUs.
+// The producer sends fixed-size messages; the consumer receives them.
+// How long does one message take, one way, and how many per second?
+//
+// Transports:
+//   shm-spin     SPSC ring in shared memory (memfd or shm_open);
+//                the consumer spins on the producer's index
+//   shm-futex    same ring; the consumer spins briefly, then sleeps on
+//                a futex in the shared page; the producer wakes it only
+//                if it is asleep
+//   pipe         write() / read()
+//   unix-stream  socketpair(AF_UNIX, SOCK_STREAM)
+//   unix-dgram   socketpair(AF_UNIX, SOCK_DGRAM)
+//
+// Each message starts with the producer's CLOCK_MONOTONIC timestamp
+// (system-wide, so valid across processes). Two phases:
+//   latency     paced: one message every GAP us, the queue stays empty
+//   throughput  back to back: the queue fills, messages per second
+//
+// THEORY:
+// - the ring needs no syscall on either side: one-way latency is a
+//   cache line transfer between cores (~100 ns) plus the copy.
+// - pipes and sockets copy twice (user -> kernel -> user) and wake the
+//   reader through the scheduler: microseconds.
+// - a futex only costs a syscall when the consumer actually slept, so
+//   shm-futex matches shm-spin under load and pipes when idle.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+static inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+static void sleep_until(int64_t t) {
+    timespec ts;
+    ts.tv_sec = t / 1'000'000'000;
+    ts.tv_nsec = t % 1'000'000'000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+// Shared (not PRIVATE) futex ops: the word lives in a MAP_SHARED page.
+static void futex_wait(std::atomic<uint32_t>* w, uint32_t val) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(w), FUTEX_WAIT, val, nullptr, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>* w) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(w), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+// ------------------------------------------------------------
+// SPSC ring in shared memory
+// ------------------------------------------------------------
+// Header on its own lines, then `slots` slots of `slot_bytes`.
+// Indices grow forever; slot = index % slots (slots is a power of two).
+
+struct RingHdr {
+    alignas(64) std::atomic<uint64_t> head{0}; // consumer
+    alignas(64) std::atomic<uint64_t> tail{0}; // producer
+    alignas(64) std::atomic<uint32_t> seq{0};  // futex word: bumped on publish
+    std::atomic<uint32_t> sleeping{0};
+    uint32_t slots = 0;
+    uint32_t slot_bytes = 0;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring needs address-free atomics");
+
+constexpr int CONSUMER_SPINS = 2000; // shm-futex: spins before sleeping
+
+class ShmRing {
+public:
+    // backing: "memfd" or "shm" (shm_open). Mapped before fork(), so
+    // both processes share it; a real deployment passes the fd / name.
+    bool create(const std::string& backing, uint32_t slots, size_t msg_size) {
+        slot_bytes_ = (uint32_t)((msg_size + 63) & ~size_t(63));
+        bytes_ = sizeof(RingHdr) + (size_t)slots * slot_bytes_;
+        int fd = -1;
+        if (backing == "shm") {
+            const std::string name = "/lat_ipc_" + std::to_string(getpid());
+            fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            shm_unlink(name.c_str()); // the mapping keeps it alive
+        } else {
+            fd = memfd_create("lat_ipc", MFD_CLOEXEC);
+        }
+        if (fd < 0 || ftruncate(fd, (off_t)bytes_) != 0) return false;
+        void* m = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) return false;
+        base_ = static_cast<char*>(m);
+        hdr_ = new (base_) RingHdr;
+        hdr_->slots = slots;
+        hdr_->slot_bytes = slot_bytes_;
+        return true;
+    }
+
+    ~ShmRing() {
+        if (base_) munmap(base_, bytes_);
+    }
+
+    void send(const char* msg, size_t n, bool futex) {
+        const uint64_t t = hdr_->tail.load(std::memory_order_relaxed);
+        while (t - hdr_->head.load(std::memory_order_acquire) >= hdr_->slots) sched_yield(); // full
+        std::memcpy(slot(t), msg, n);
+        hdr_->tail.store(t + 1, std::memory_order_release);
+        if (futex) {
+            // Pairs with the consumer's fence: either it sees the new
+            // tail, or we see it asleep.
+            hdr_->seq.fetch_add(1, std::memory_order_seq_cst);
+            if (hdr_->sleeping.load(std::memory_order_seq_cst)) futex_wake(&hdr_->seq);
+        }
+    }
+
+    void recv(char* out, size_t n, bool futex) {
+        const uint64_t h = hdr_->head.load(std::memory_order_relaxed);
+        int spins = 0;
+        while (hdr_->tail.load(std::memory_order_acquire) == h) {
+            if (!futex || ++spins < CONSUMER_SPINS) {
+                cpu_relax();
+                continue;
+            }
+            const uint32_t s = hdr_->seq.load(std::memory_order_seq_cst);
+            hdr_->sleeping.store(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (hdr_->tail.load(std::memory_order_seq_cst) == h) futex_wait(&hdr_->seq, s);
+            hdr_->sleeping.store(0, std::memory_order_relaxed);
+            spins = 0;
+        }
+        std::memcpy(out, slot(h), n);
+        hdr_->head.store(h + 1, std::memory_order_release);
+    }
+
+private:
+    char* slot(uint64_t i) { return base_ + sizeof(RingHdr) + (i & (hdr_->slots - 1)) * slot_bytes_; }
+
+    char*    base_ = nullptr;
+    RingHdr* hdr_ = nullptr;
+    size_t   bytes_ = 0;
+    uint32_t slot_bytes_ = 0;
+};
+
+// ------------------------------------------------------------
+// Transports
+// ------------------------------------------------------------
+
+enum class Kind { ShmSpin, ShmFutex, Pipe, UnixStream, UnixDgram };
+
+static const char* kind_name(Kind k) {
+    switch (k) {
+        case Kind::ShmSpin:    return "shm-spin";
+        case Kind::ShmFutex:   return "shm-futex";
+        case Kind::Pipe:       return "pipe";
+        case Kind::UnixStream: return "unix-stream";
+        case Kind::UnixDgram:  return "unix-dgram";
+    }
+    return "?";
+}
+
+struct Config {
+    size_t      size = 64;
+    int         lat_msgs = 20'000;
+    int         tput_msgs = 200'000;
+    int64_t     gap_us = 50;
+    std::string backing = "memfd";
+    uint32_t    slots = 1024;
+};
+
+struct Transport {
+    Kind    kind;
+    ShmRing ring;
+    int     wfd = -1; // producer end
+    int     rfd = -1; // consumer end
+
+    bool open(const Config& cfg) {
+        if (kind == Kind::ShmSpin || kind == Kind::ShmFutex) return ring.create(cfg.backing, cfg.slots, cfg.size);
+        int fds[2];
+        if (kind == Kind::Pipe) {
+            if (pipe(fds) != 0) return false;
+            rfd = fds[0];
+            wfd = fds[1];
+            return true;
+        }
+        if (socketpair(AF_UNIX, kind == Kind::UnixStream ? SOCK_STREAM : SOCK_DGRAM, 0, fds) != 0) return false;
+        wfd = fds[0];
+        rfd = fds[1];
+        return true;
+    }
+
+    // false: the peer is gone (EOF / EPIPE) or the call failed; errno
+    // is 0 for EOF. The buffer then holds no message.
+    bool send(const char* msg, size_t n) {
+        if (kind == Kind::ShmSpin || kind == Kind::ShmFutex) {
+            ring.send(msg, n, kind == Kind::ShmFutex);
+            return true;
+        }
+        size_t done = 0;
+        while (done < n) {
+            const ssize_t r = write(wfd, msg + done, n - done);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            done += (size_t)r;
+        }
+        return true;
+    }
+
+    bool recv(char* out, size_t n) {
+        if (kind == Kind::ShmSpin || kind == Kind::ShmFutex) {
+            ring.recv(out, n, kind == Kind::ShmFutex);
+            return true;
+        }
+        size_t done = 0;
+        while (done < n) {
+            const ssize_t r = read(rfd, out + done, n - done);
+            if (r < 0 && errno == EINTR) continue;
+            if (r == 0) errno = 0;
+            if (r <= 0) return false;
+            done += (size_t)r;
+        }
+        return true;
+    }
+
+    ~Transport() {
+        if (wfd >= 0) close(wfd);
+        if (rfd >= 0) close(rfd);
+    }
+};
+
+static void report_io_error(const char* who, Kind k, int i) {
+    std::printf("%s: %s failed at message %d (%s)\n", kind_name(k), who, i,
+                errno ? std::strerror(errno) : "peer closed");
+}
+
+// Consumer process: receives both phases, prints its own results.
+// Returns false if the transport failed; nothing is printed but the error.
+static bool consumer_main(Transport& tr, const Config& cfg) {
+    pin_to(1);
+    std::vector<char> buf(cfg.size);
+    std::vector<uint64_t> lat;
+    lat.reserve(cfg.lat_msgs);
+    for (int i = 0; i < cfg.lat_msgs; i++) {
+        if (!tr.recv(buf.data(), cfg.size)) {
+            report_io_error("recv", tr.kind, i);
+            return false;
+        }
+        const int64_t t_recv = now_ns();
+        int64_t t_send;
+        std::memcpy(&t_send, buf.data(), sizeof(t_send));
+        lat.push_back((uint64_t)std::max<int64_t>(0, t_recv - t_send));
+    }
+
+    int64_t t_first = 0;
+    for (int i = 0; i < cfg.tput_msgs; i++) {
+        if (!tr.recv(buf.data(), cfg.size)) {
+            report_io_error("recv", tr.kind, cfg.lat_msgs + i);
+            return false;
+        }
+        if (i == 0) t_first = now_ns();
+        sink = sink + (uint64_t)buf[cfg.size - 1];
+    }
+    const double secs = (double)(now_ns() - t_first) / 1e9;
+    const double mps = cfg.tput_msgs > 1 ? (double)(cfg.tput_msgs - 1) / secs : 0.0;
+
+    const std::string title = std::string(kind_name(tr.kind)) + ": one-way latency (ns), " +
+                              lat::format_bytes(cfg.size) + " messages";
+    lat::print_stats(title.c_str(), lat::compute_stats(std::move(lat)));
+    std::printf("throughput: %.2f M msg/s, %.1f MB/s\n\n", mps / 1e6, mps * (double)cfg.size / 1e6);
+    return true;
+}
+
+static bool producer_main(Transport& tr, const Config& cfg) {
+    pin_to(0);
+    std::vector<char> msg(cfg.size, 'x');
+    int64_t next = now_ns() + 10'000'000; // give the consumer time to start
+    for (int i = 0; i < cfg.lat_msgs; i++) {
+        sleep_until(next);
+        next += cfg.gap_us * 1000;
+        const int64_t t = now_ns();
+        std::memcpy(msg.data(), &t, sizeof(t));
+        if (!tr.send(msg.data(), cfg.size)) {
+            report_io_error("send", tr.kind, i);
+            return false;
+        }
+    }
+    for (int i = 0; i < cfg.tput_msgs; i++) {
+        msg[cfg.size - 1] = (char)i;
+        if (!tr.send(msg.data(), cfg.size)) {
+            report_io_error("send", tr.kind, cfg.lat_msgs + i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool run_kind(Kind k, const Config& cfg) {
+    Transport tr;
+    tr.kind = k;
+    if (!tr.open(cfg)) {
+        std::printf("%s: setup failed (%s)\n\n", kind_name(k), std::strerror(errno));
+        return false;
+    }
+    std::fflush(stdout); // do not duplicate buffered output into the child
+    const pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (tr.wfd >= 0) {
+            close(tr.wfd);
+            tr.wfd = -1;
+        }
+        const bool ok = consumer_main(tr, cfg);
+        std::fflush(stdout);
+        std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+        std::fflush(stderr);
+        _exit(ok ? 0 : 1);
+    }
+    if (tr.rfd >= 0) {
+        close(tr.rfd);
+        tr.rfd = -1;
+    }
+    const bool sent = producer_main(tr, cfg);
+    std::fflush(stdout);
+    if (tr.wfd >= 0) { // a consumer still blocked in read() sees EOF
+        close(tr.wfd);
+        tr.wfd = -1;
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return sent && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    const int ncpu = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    Config cfg;
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--size=", 0) == 0)           cfg.size = (size_t)std::clamp(std::atoi(a.c_str() + 7), 16, 65536);
+        else if (a.rfind("--lat-msgs=", 0) == 0)  cfg.lat_msgs = std::max(1, std::atoi(a.c_str() + 11));
+        else if (a.rfind("--tput-msgs=", 0) == 0) cfg.tput_msgs = std::max(1, std::atoi(a.c_str() + 12));
+        else if (a.rfind("--gap-us=", 0) == 0)    cfg.gap_us = std::max(0L, std::atol(a.c_str() + 9));
+        else if (a.rfind("--backing=", 0) == 0)   cfg.backing = a.substr(10);
+        else only = a;
+    }
+
+    signal(SIGPIPE, SIG_IGN); // a dead consumer is an EPIPE from send(), not a kill
+
+    std::printf("Cross-process IPC: producer on CPU 0, consumer on CPU 1 (%d CPUs online)\n", ncpu);
+    std::printf("%s messages; latency phase: %d msgs every %lld us; throughput phase: %d msgs\n",
+                lat::format_bytes(cfg.size).c_str(), cfg.lat_msgs, (long long)cfg.gap_us, cfg.tput_msgs);
+    std::printf("ring: %s-backed, %u slots\n", cfg.backing.c_str(), cfg.slots);
+    if (ncpu < 2) {
+        std::printf("NOTE: 1 CPU: both processes share it; a spinning consumer delays the producer.\n");
+    }
+    std::printf("\n");
+
+    const Kind kinds[] = {Kind::ShmSpin, Kind::ShmFutex, Kind::Pipe, Kind::UnixStream, Kind::UnixDgram};
+    bool all_ok = true;
+    for (Kind k : kinds) {
+        if (!only.empty() && only != kind_name(k)) continue;
+        if (!run_kind(k, cfg)) {
+            std::printf("%s: failed\n\n", kind_name(k));
+            all_ok = false;
+        }
+    }
+
+    std::printf("Interpretation:\n");
+    std::printf("  shm rows: no syscall per message; their tail is the consumer's wait strategy.\n");
+    std::printf("  pipe / unix rows: two copies and a scheduler wakeup per message.\n");
+    std::printf("  Compare p99.9 at the same size: that is the price of the kernel in the path.\n");
+
+    std::fflush(stdout);
+    return all_ok ? 0 : 1;
+}
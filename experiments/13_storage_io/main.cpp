@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+#include "../common/uring.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// A journal appends a record and must know it is durable before it
+// acknowledges. The cost of "durable" is a distribution with a long
+// tail; measure it per operation, like every other workload here.
+//
+// Each row appends OPS records of SIZE bytes to one file:
+//
+//   buffered          pwrite() only: lands in the page cache
+//   fdatasync         pwrite() + fdatasync(): data (+ size if it grew)
+//   fsync             pwrite() + fsync(): data + all metadata
+//   O_DSYNC           pwrite() on an O_DSYNC fd: sync inside the write
+//   O_DIRECT          aligned pwrite() bypassing the page cache (no sync)
+//   O_DIRECT|O_DSYNC  direct + synchronous: the "real" journal write
+//   uring             io_uring WRITE_FIXED (registered buffer), O_DIRECT
+//   uring+fdatasync   WRITE_FIXED linked to FSYNC(DATASYNC), one submit
+//
+// One sample = ns from issuing the write to the call (or the CQE)
+// returning. File layout before the first op:
+//
+//   zeroed     (default) written with zeros and fsync'ed, like a real
+//              journal's segment file: the data syncs persist data only
+//   fallocate  posix_fallocate: on ext4 / xfs that makes UNWRITTEN
+//              extents, so every first write converts one and its sync
+//              commits a metadata transaction too
+//   grow       empty: every sync also persists the new size
+//
+// THEORY:
+// - buffered writes are a memcpy until dirty-page throttling kicks in
+//   (balance_dirty_pages): then they block for milliseconds.
+// - every sync waits for the device AND the filesystem journal;
+//   fsync can also force a journal commit for metadata (mtime).
+// - O_DIRECT skips the copy into the page cache but not the device.
+// - io_uring removes nothing from the device wait; it removes the
+//   per-call syscall + setup cost and lets the app keep working.
+// - on tmpfs there is no device: sync is nearly free, O_DIRECT may fail.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+enum class Mode { Buffered, Fdatasync, Fsync, Dsync, Direct, DirectDsync, Uring, UringSync };
+
+static const char* mode_name(Mode m) {
+    switch (m) {
+        case Mode::Buffered:    return "buffered";
+        case Mode::Fdatasync:   return "fdatasync";
+        case Mode::Fsync:       return "fsync";
+        case Mode::Dsync:       return "O_DSYNC";
+        case Mode::Direct:      return "O_DIRECT";
+        case Mode::DirectDsync: return "O_DIRECT|O_DSYNC";
+        case Mode::Uring:       return "uring";
+        case Mode::UringSync:   return "uring+fdatasync";
+    }
+    return "?";
+}
+
+static int open_flags(Mode m) {
+    int f = O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (m == Mode::Dsync || m == Mode::DirectDsync) f |= O_DSYNC;
+    if (m == Mode::Direct || m == Mode::DirectDsync || m == Mode::Uring || m == Mode::UringSync) f |= O_DIRECT;
+    return f;
+}
+
+enum class Layout { Zeroed, Fallocate, Grow };
+
+static const char* layout_name(Layout l) {
+    switch (l) {
+        case Layout::Zeroed:    return "pre-zeroed and fsync'ed";
+        case Layout::Fallocate: return "fallocate'd (unwritten extents: first writes convert them)";
+        case Layout::Grow:      return "growing (no preallocation)";
+    }
+    return "?";
+}
+
+struct Config {
+    std::string dir = ".";
+    size_t      size = 4096;
+    int         ops = 2000;
+    Layout      layout = Layout::Zeroed;
+};
+
+// Writes zeros over [0, total) through fd (which may be O_DIRECT: the
+// buffer is aligned and total is a multiple of 512), then fsyncs.
+static std::string zero_fill(int fd, off_t total) {
+    constexpr size_t CHUNK = 1 << 20;
+    void* z = nullptr;
+    if (posix_memalign(&z, 4096, CHUNK) != 0) return "posix_memalign failed";
+    std::memset(z, 0, CHUNK);
+    std::string err;
+    for (off_t off = 0; off < total && err.empty();) {
+        const size_t n = (size_t)std::min<off_t>((off_t)CHUNK, total - off);
+        if (pwrite(fd, z, n, off) != (ssize_t)n) err = std::string("zero fill: ") + std::strerror(errno);
+        off += (off_t)n;
+    }
+    std::free(z);
+    if (err.empty() && fsync(fd) != 0) err = std::string("zero fill fsync: ") + std::strerror(errno);
+    return err;
+}
+
+static void print_row(const char* name, const lat::Stats& s, double secs) {
+    std::printf("%-18s %6zu %9llu %9llu %9llu %10llu %11llu %9.0f\n",
+                name, s.n, (unsigned long long)s.min, (unsigned long long)s.p50,
+                (unsigned long long)s.p99, (unsigned long long)s.p999,
+                (unsigned long long)s.max, secs > 0 ? (double)s.n / secs : 0.0);
+}
+
+// Returns an error string, or "" on success.
+static std::string run_mode(Mode m, const Config& cfg) {
+    const std::string path = cfg.dir + "/lat_journal.bin";
+    const int fd = open(path.c_str(), open_flags(m), 0600);
+    if (fd < 0) return std::string("open: ") + std::strerror(errno);
+    unlink(path.c_str()); // removed on close, even if we crash
+
+    const off_t total = (off_t)cfg.size * cfg.ops;
+    if (cfg.layout == Layout::Zeroed) {
+        if (std::string e = zero_fill(fd, total); !e.empty()) {
+            close(fd);
+            return e;
+        }
+    } else if (cfg.layout == Layout::Fallocate) {
+        if (const int e = posix_fallocate(fd, 0, total); e != 0) {
+            close(fd);
+            return std::string("fallocate: ") + std::strerror(e);
+        }
+        fsync(fd); // allocation itself persisted before we start
+    }
+
+    // 4 KB alignment satisfies O_DIRECT on every common device.
+    void* mem = nullptr;
+    if (posix_memalign(&mem, 4096, cfg.size) != 0) {
+        close(fd);
+        return "posix_memalign failed";
+    }
+    char* buf = static_cast<char*>(mem);
+    std::memset(buf, 'j', cfg.size);
+
+    lat::Uring ring;
+    const bool uring = m == Mode::Uring || m == Mode::UringSync;
+    if (uring) {
+        if (const int e = ring.init(8); e < 0) {
+            std::free(mem);
+            close(fd);
+            return std::string("io_uring: ") + std::strerror(-e);
+        }
+        iovec iov{buf, cfg.size};
+        if (const int e = ring.register_buffers(&iov, 1); e < 0) {
+            std::free(mem);
+            close(fd);
+            return std::string("register_buffers: ") + std::strerror(-e);
+        }
+    }
+
+    std::vector<uint64_t> samples;
+    samples.reserve(cfg.ops);
+    std::string err;
+    const int64_t start = now_ns();
+
+    for (int i = 0; i < cfg.ops && err.empty(); i++) {
+        const off_t off = (off_t)i * (off_t)cfg.size;
+        std::memcpy(buf, &i, sizeof(i)); // record header
+
+        const int64_t t0 = now_ns();
+        if (!uring) {
+            if (pwrite(fd, buf, cfg.size, off) != (ssize_t)cfg.size) {
+                err = std::string("pwrite: ") + std::strerror(errno);
+                break;
+            }
+            // A failed sync must not show up as a fast "durable" sample.
+            if (m == Mode::Fdatasync && fdatasync(fd) != 0) err = std::string("fdatasync: ") + std::strerror(errno);
+            if (m == Mode::Fsync && fsync(fd) != 0) err = std::string("fsync: ") + std::strerror(errno);
+            if (!err.empty()) break;
+        } else {
+            io_uring_sqe* sqe = ring.get_sqe();
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->fd = fd;
+            sqe->addr = (uint64_t)(uintptr_t)buf;
+            sqe->len = (uint32_t)cfg.size;
+            sqe->off = (uint64_t)off;
+            sqe->buf_index = 0;
+            sqe->user_data = 0; // the write; 1 = the fsync
+            unsigned expect = 1;
+            if (m == Mode::UringSync) {
+                sqe->flags |= IOSQE_IO_LINK; // fsync only after the write completed
+                sqe = ring.get_sqe();
+                sqe->opcode = IORING_OP_FSYNC;
+                sqe->fd = fd;
+                sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+                sqe->user_data = 1;
+                expect = 2;
+            }
+            ring.submit(expect);
+            for (unsigned k = 0; k < expect; k++) {
+                io_uring_cqe* cqe = ring.wait_cqe();
+                const int res = cqe ? cqe->res : -EIO;
+                const bool is_write = cqe && cqe->user_data == 0;
+                ring.cqe_seen();
+                if (!err.empty()) continue;
+                if (res < 0) err = std::string(is_write ? "io_uring write: " : "io_uring fsync: ") + std::strerror(-res);
+                else if (is_write && res != (int)cfg.size)
+                    err = "io_uring write: short write (" + std::to_string(res) + " of " + std::to_string(cfg.size) + " bytes)";
+            }
+        }
+        const int64_t t1 = now_ns();
+        samples.push_back((uint64_t)(t1 - t0));
+    }
+    const double secs = (double)(now_ns() - start) / 1e9;
+
+    sink = sink + (uint64_t)buf[0];
+    std::free(mem);
+    close(fd);
+    if (!err.empty()) return err;
+    print_row(mode_name(m), lat::compute_stats(std::move(samples)), secs);
+    return "";
+}
+
+static std::string fs_type(const std::string& dir) {
+    // Best effort: the mount whose path is the longest prefix of dir.
+    char real[4096];
+    if (!realpath(dir.c_str(), real)) return "?";
+    FILE* f = std::fopen("/proc/self/mounts", "r");
+    if (!f) return "?";
+    char dev[256], mnt[1024], type[64];
+    std::string best = "?";
+    size_t best_len = 0;
+    while (std::fscanf(f, "%255s %1023s %63s %*s %*d %*d", dev, mnt, type) == 3) {
+        const size_t n = std::strlen(mnt);
+        const bool prefix = std::strncmp(real, mnt, n) == 0 && (real[n] == '/' || real[n] == '\0' || n == 1);
+        if (prefix && n >= best_len) {
+            best_len = n;
+            best = type;
+        }
+    }
+    std::fclose(f);
+    return best;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--dir=", 0) == 0)       cfg.dir = a.substr(6);
+        else if (a.rfind("--size=", 0) == 0) cfg.size = (size_t)std::max(512, std::atoi(a.c_str() + 7));
+        else if (a.rfind("--ops=", 0) == 0)  cfg.ops = std::max(1, std::atoi(a.c_str() + 6));
+        else if (a == "--grow")              cfg.layout = Layout::Grow;
+        else if (a == "--fallocate")         cfg.layout = Layout::Fallocate;
+        else only = a;
+    }
+    // O_DIRECT needs sizes in multiples of the logical block size.
+    cfg.size = (cfg.size + 511) & ~size_t(511);
+
+    std::printf("Journal append latency (ns per op): %s records, %d ops per row\n",
+                lat::format_bytes(cfg.size).c_str(), cfg.ops);
+    std::printf("file: %s/lat_journal.bin (%s), %s\n", cfg.dir.c_str(), fs_type(cfg.dir).c_str(),
+                layout_name(cfg.layout));
+    std::printf("%-18s %6s %9s %9s %9s %10s %11s %9s\n",
+                "mode", "n", "min", "p50", "p99", "p99.9", "max", "ops/s");
+
+    const Mode modes[] = {Mode::Buffered, Mode::Fdatasync, Mode::Fsync, Mode::Dsync,
+                          Mode::Direct, Mode::DirectDsync, Mode::Uring, Mode::UringSync};
+    for (Mode m : modes) {
+        if (!only.empty() && only != mode_name(m)) continue;
+        const std::string err = run_mode(m, cfg);
+        if (!err.empty()) std::printf("%-18s  (%s)\n", mode_name(m), err.c_str());
+    }
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  buffered is not durable; compare the durable rows with each other.\n");
+    std::printf("  The sync rows' p99.9 / max is the device + filesystem journal tail.\n");
+    std::printf("  Run with --dir= on the journal's real filesystem; tmpfs measures no device.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
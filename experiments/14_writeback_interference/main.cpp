@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "../common/stats.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// The measured thread never does I/O. Another thread of the same
+// process dirties page cache as fast as it can. Does the hot path
+// notice?
+//
+// Measured thread (CPU 0): every TICK ns (spinning in between, like a
+// thread waiting for market data) run one op and time it:
+//   baseline  the tiny arithmetic of `latency baseline`
+//   memory    8 dependent random reads in a pre-faulted MEM_MB buffer
+//
+// Writer thread (CPU 1), per row:
+//   none      idle: the reference distribution
+//   buffered  pwrite() 1 MB chunks over a DIRTY_MB file, wrapping
+//   mmap      memset 1 MB chunks of a DIRTY_MB MAP_SHARED file, wrapping
+// optionally with sync_file_range (sfr): start writeback of each
+// 8 MB chunk right away and wait for the previous one, so dirty
+// memory stays at ~2 chunks instead of growing to the dirty limit.
+//
+// THEORY:
+// - dirty pages above vm.dirty_background_* wake the flusher threads;
+//   above vm.dirty_* the WRITER is throttled (balance_dirty_pages).
+// - neither should stall an unrelated thread, but writeback and
+//   reclaim take shared locks (LRU, mapping tree, journal), burn
+//   CPU in softirq / kworkers, evict our cache lines and TLB entries,
+//   and may steal our core.
+// - sync_file_range bounds the dirty set: less burst, steadier rate.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+static long read_long(const char* path) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) return -1;
+    long v = -1;
+    if (std::fscanf(f, "%ld", &v) != 1) v = -1;
+    std::fclose(f);
+    return v;
+}
+
+// "Dirty:" + "Writeback:" from /proc/meminfo, in KB.
+static long dirty_kb() {
+    FILE* f = std::fopen("/proc/meminfo", "r");
+    if (!f) return -1;
+    char key[64];
+    long v = 0, total = 0;
+    while (std::fscanf(f, "%63s %ld kB", key, &v) == 2) {
+        if (!std::strcmp(key, "Dirty:") || !std::strcmp(key, "Writeback:")) total += v;
+    }
+    std::fclose(f);
+    return total;
+}
+
+enum class Writer { None, Buffered, Mmap };
+
+static const char* writer_name(Writer w) {
+    switch (w) {
+        case Writer::None:     return "none";
+        case Writer::Buffered: return "buffered";
+        case Writer::Mmap:     return "mmap";
+    }
+    return "?";
+}
+
+struct Config {
+    std::string         dir = ".";
+    bool                memory = false;
+    double              seconds = 2.0;
+    int64_t             tick_ns = 2000;
+    size_t              mem_mb = 256;
+    std::vector<size_t> dirty_mb = {256, 1024};
+};
+
+struct WriterResult {
+    uint64_t    bytes = 0;
+    long        max_dirty_kb = 0;
+    std::string error;
+};
+
+constexpr size_t CHUNK     = 1 << 20;        // buffered write size
+constexpr size_t SFR_CHUNK = 8 << 20;        // sync_file_range granularity
+
+static void writer_main(Writer w, size_t dirty_bytes, bool sfr, const Config& cfg,
+                        std::atomic<bool>& stop, WriterResult& r) {
+    pin_to(1);
+    const std::string path = cfg.dir + "/lat_writeback.bin";
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        r.error = std::string("open: ") + std::strerror(errno);
+        return;
+    }
+    unlink(path.c_str());
+    if (ftruncate(fd, (off_t)dirty_bytes) != 0) {
+        r.error = std::string("ftruncate: ") + std::strerror(errno);
+        close(fd);
+        return;
+    }
+
+    char* map = nullptr;
+    if (w == Writer::Mmap) {
+        void* m = mmap(nullptr, dirty_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) {
+            r.error = std::string("mmap: ") + std::strerror(errno);
+            close(fd);
+            return;
+        }
+        map = static_cast<char*>(m);
+    }
+    std::vector<char> buf(CHUNK, 'w');
+
+    size_t off = 0;
+    size_t since_sfr = 0;
+    uint64_t gen = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (w == Writer::Buffered) {
+            if (pwrite(fd, buf.data(), CHUNK, (off_t)off) != (ssize_t)CHUNK) {
+                r.error = std::string("pwrite: ") + std::strerror(errno);
+                break;
+            }
+        } else {
+            // Whole pages, like pwrite: r.bytes is what was really stored.
+            std::memset(map + off, (int)(gen & 0xff), CHUNK);
+        }
+        off += CHUNK;
+        since_sfr += CHUNK;
+        r.bytes += CHUNK;
+
+        if (sfr && since_sfr >= SFR_CHUNK) {
+            // Kick writeback of the chunk just written; wait for the
+            // one before it. Dirty memory stays ~2 chunks.
+            const off_t cur = (off_t)(off - SFR_CHUNK);
+            sync_file_range(fd, cur, SFR_CHUNK, SYNC_FILE_RANGE_WRITE);
+            if (cur >= (off_t)SFR_CHUNK) {
+                sync_file_range(fd, cur - (off_t)SFR_CHUNK, SFR_CHUNK,
+                                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                                SYNC_FILE_RANGE_WAIT_AFTER);
+            }
+            since_sfr = 0;
+        }
+        if (off + CHUNK > dirty_bytes) {
+            off = 0;
+            since_sfr = 0;
+            gen++;
+        }
+        if ((r.bytes & ((16u << 20) - 1)) == 0) r.max_dirty_kb = std::max(r.max_dirty_kb, dirty_kb());
+    }
+
+    if (map) munmap(map, dirty_bytes);
+    close(fd); // no fsync: dropping the file discards what is still dirty
+}
+
+// One measured op.
+static inline uint64_t op_baseline(uint64_t x) {
+    return x ^ ((x << 1) + 0x9e3779b97f4a7c15ull);
+}
+
+static inline uint64_t op_memory(const uint64_t* mem, size_t words, uint64_t x) {
+    for (int k = 0; k < 8; k++) x = mem[(x * 0x9e3779b97f4a7c15ull >> 20) % words] + x + 1;
+    return x;
+}
+
+static void run_row(Writer w, size_t dirty_mb, bool sfr, const Config& cfg,
+                    const std::vector<uint64_t>& mem) {
+    std::atomic<bool> stop{false};
+    WriterResult wr;
+    std::thread writer;
+    if (w != Writer::None) {
+        writer = std::thread(writer_main, w, dirty_mb << 20, sfr, std::cref(cfg), std::ref(stop), std::ref(wr));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200)); // let dirty memory build up
+    }
+
+    pin_to(0);
+    const size_t cap = (size_t)(cfg.seconds * 1e9 / (double)cfg.tick_ns) + 16;
+    std::vector<uint64_t> samples;
+    samples.reserve(cap);
+    const size_t words = mem.size();
+    uint64_t x = sink;
+
+    const int64_t start = now_ns();
+    const int64_t end = start + (int64_t)(cfg.seconds * 1e9);
+    int64_t next = start;
+    while (samples.size() < cap) {
+        int64_t t;
+        while ((t = now_ns()) < next) cpu_relax(); // waiting for the next "event"
+        if (t >= end) break;
+        const int64_t t0 = now_ns();
+        x = cfg.memory ? op_memory(mem.data(), words, x) : op_baseline(x);
+        const int64_t t1 = now_ns();
+        samples.push_back((uint64_t)(t1 - t0));
+        next += cfg.tick_ns;
+        if (next < t1) next = t1; // stalled past several ticks: do not replay them
+    }
+    const double secs = (double)(now_ns() - start) / 1e9;
+    sink = sink + x;
+
+    stop.store(true, std::memory_order_relaxed);
+    if (writer.joinable()) writer.join();
+
+    char label[48];
+    if (w == Writer::None) std::snprintf(label, sizeof(label), "none");
+    else std::snprintf(label, sizeof(label), "%s %zuMB%s", writer_name(w), dirty_mb, sfr ? " +sfr" : "");
+    if (!wr.error.empty()) {
+        std::printf("%-20s  (writer: %s)\n", label, wr.error.c_str());
+        return;
+    }
+
+    size_t over_10us = 0;
+    for (uint64_t s : samples) over_10us += s > 10'000;
+    const lat::Stats s = lat::compute_stats(std::move(samples));
+    std::printf("%-20s %8zu %6llu %7llu %8llu %10llu %7zu %8.0f %9ld\n",
+                label, s.n, (unsigned long long)s.p50, (unsigned long long)s.p99,
+                (unsigned long long)s.p999, (unsigned long long)s.max, over_10us,
+                (double)wr.bytes / 1e6 / secs, wr.max_dirty_kb / 1024);
+}
+
+int main(int argc, char** argv) {
+    const int ncpu = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    Config cfg;
+    std::string only_writer;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a == "memory")                       cfg.memory = true;
+        else if (a == "baseline")                cfg.memory = false;
+        else if (a == "buffered" || a == "mmap") only_writer = a;
+        else if (a.rfind("--dir=", 0) == 0)      cfg.dir = a.substr(6);
+        else if (a.rfind("--seconds=", 0) == 0)  cfg.seconds = std::max(0.1, std::atof(a.c_str() + 10));
+        else if (a.rfind("--tick-ns=", 0) == 0)  cfg.tick_ns = std::max(100L, std::atol(a.c_str() + 10));
+        else if (a.rfind("--mem-mb=", 0) == 0)   cfg.mem_mb = (size_t)std::max(1, std::atoi(a.c_str() + 9));
+        else if (a.rfind("--dirty-mb=", 0) == 0) {
+            // Comma-separated sweep, e.g. --dirty-mb=64,256,1024
+            cfg.dirty_mb.clear();
+            std::string list = a.substr(11);
+            size_t pos = 0;
+            while (pos < list.size()) {
+                const size_t comma = list.find(',', pos);
+                const int v = std::atoi(list.substr(pos, comma - pos).c_str());
+                if (v > 0) cfg.dirty_mb.push_back((size_t)v);
+                if (comma == std::string::npos) break;
+                pos = comma + 1;
+            }
+        }
+    }
+
+    std::vector<uint64_t> mem;
+    if (cfg.memory) {
+        mem.resize((cfg.mem_mb << 20) / sizeof(uint64_t)); // value-initialised: pre-faulted
+        for (size_t i = 0; i < mem.size(); i++) mem[i] = i * 2654435761u;
+    }
+
+    std::printf("Writeback interference: measured '%s' op every %lld ns on CPU 0, writer on CPU 1\n",
+                cfg.memory ? "memory" : "baseline", (long long)cfg.tick_ns);
+    std::printf("%.1fs per row; file in %s\n", cfg.seconds, cfg.dir.c_str());
+    std::printf("vm.dirty_ratio=%ld dirty_background_ratio=%ld dirty_bytes=%ld dirty_background_bytes=%ld "
+                "dirty_expire_centisecs=%ld\n",
+                read_long("/proc/sys/vm/dirty_ratio"), read_long("/proc/sys/vm/dirty_background_ratio"),
+                read_long("/proc/sys/vm/dirty_bytes"), read_long("/proc/sys/vm/dirty_background_bytes"),
+                read_long("/proc/sys/vm/dirty_expire_centisecs"));
+    if (ncpu < 2) {
+        std::printf("NOTE: 1 CPU: the writer also competes for the measured thread's core.\n");
+    }
+    std::printf("%-20s %8s %6s %7s %8s %10s %7s %8s %9s\n",
+                "writer", "n", "p50", "p99", "p99.9", "max", ">10us", "st MB/s", "dirty MB");
+
+    run_row(Writer::None, 0, false, cfg, mem);
+    for (Writer w : {Writer::Buffered, Writer::Mmap}) {
+        if (!only_writer.empty() && only_writer != writer_name(w)) continue;
+        for (size_t mb : cfg.dirty_mb) {
+            run_row(w, mb, false, cfg, mem);
+            run_row(w, mb, true, cfg, mem);
+        }
+    }
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  Compare each row with 'none': the measured op did no I/O in any row.\n");
+    std::printf("  'dirty MB' is the peak Dirty + Writeback seen by the writer (/proc/meminfo).\n");
+    std::printf("  +sfr rows bound the dirty set; if their tail is shorter, writeback bursts were the cause.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/async_logger.hpp"
+#include "../common/stats.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// A latency-critical loop that also has to log. What does one log
+// line cost the HOT thread, at p50 and in the tail?
+//
+// Each iteration does a small fixed amount of work, then (every
+// EVERY iterations) logs one line with three arguments:
+//
+//   none      no logging: the floor
+//   async     lat::AsyncLogger: binary record into a per-thread SPSC
+//             ring; a writer thread on a housekeeping CPU formats
+//   printf    fprintf() to a fully buffered FILE*
+//   iostream  std::ofstream << ... (buffered, std::endl NOT used)
+//   write     snprintf() + write(2) per line: unbuffered
+//
+// One sample = ns for one iteration, work + log call. Iterations are
+// paced (GAP ns of busy-wait outside the timed region) so the async
+// writer can keep up, as it must in production.
+//
+// THEORY:
+// - buffered stdio/iostream are cheap on average (format + memcpy) but
+//   every ~4-64 KB one unlucky line pays the write() syscall, and
+//   the page cache can stall that write for milliseconds.
+// - write() per line pays the syscall every time.
+// - the async path never formats and never enters the kernel: its
+//   cost is ~a dozen stores, independent of the format string.
+// - it moves the work, it does not remove it: the writer needs a CPU.
+//   Sharing the hot thread's CPU brings back preemption spikes.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+static inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+enum class Sink { None, Async, Printf, Iostream, Write };
+
+static const char* sink_name(Sink s) {
+    switch (s) {
+        case Sink::None:     return "none";
+        case Sink::Async:    return "async";
+        case Sink::Printf:   return "printf";
+        case Sink::Iostream: return "iostream";
+        case Sink::Write:    return "write";
+    }
+    return "?";
+}
+
+struct Config {
+    std::string out = "./lat_log.txt";
+    int         iters = 200'000;
+    int         every = 1;
+    int         gap_ns = 2000;
+    int         cpu = 0;
+    int         writer_cpu = -1;
+};
+
+// The "real work" between log lines: a short dependent chain.
+static inline uint64_t work(uint64_t x) {
+    for (int k = 0; k < 32; k++) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return x;
+}
+
+static void spin_until(int64_t deadline) {
+    while (now_ns() < deadline) {
+    }
+}
+
+struct Result {
+    lat::Stats stats;
+    uint64_t   dropped = 0;
+    double     drain_ms = 0; // time to flush/drain after the loop
+};
+
+// Returns false (with a message printed) if the output cannot be opened.
+static bool run_sink(Sink s, const Config& cfg, Result& res) {
+    // Fresh file per row; unlinked so nothing is left behind.
+    const int fd = open(cfg.out.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::printf("%-10s  (open %s: %s)\n", sink_name(s), cfg.out.c_str(), std::strerror(errno));
+        return false;
+    }
+    FILE* f = nullptr;
+    std::ofstream os;
+    if (s == Sink::Printf || s == Sink::Async) f = fdopen(dup(fd), "w");
+    if (s == Sink::Iostream) os.open(cfg.out, std::ios::out | std::ios::app);
+    unlink(cfg.out.c_str());
+
+    lat::AsyncLogger alog(f ? f : stdout, cfg.writer_cpu);
+    if (s == Sink::Async) {
+        alog.start();
+        alog.prepare(); // ring allocated and faulted in now, not in the timed loop
+    }
+
+    std::vector<uint64_t> samples;
+    samples.reserve(cfg.iters);
+    uint64_t x = 1;
+    char line[128];
+
+    for (int i = 0; i < cfg.iters; i++) {
+        spin_until(now_ns() + cfg.gap_ns);
+        const bool log_now = i % cfg.every == 0;
+        const uint64_t id = (uint64_t)i;
+        const double px = 100.0 + (double)(i & 1023) * 0.01;
+        const int qty = (int)(x & 0xff);
+
+        const int64_t t0 = now_ns();
+        x = work(x);
+        if (log_now) {
+            switch (s) {
+                case Sink::None: break;
+                case Sink::Async:
+                    alog.log("fill id=%llu px=%.2f qty=%d\n", (unsigned long long)id, px, qty);
+                    break;
+                case Sink::Printf:
+                    std::fprintf(f, "fill id=%llu px=%.2f qty=%d\n", (unsigned long long)id, px, qty);
+                    break;
+                case Sink::Iostream:
+                    os << "fill id=" << id << " px=" << px << " qty=" << qty << '\n';
+                    break;
+                case Sink::Write: {
+                    const int n = std::snprintf(line, sizeof(line), "fill id=%llu px=%.2f qty=%d\n",
+                                                (unsigned long long)id, px, qty);
+                    sink = sink + (uint64_t)write(fd, line, (size_t)n);
+                    break;
+                }
+            }
+        }
+        const int64_t t1 = now_ns();
+        samples.push_back((uint64_t)(t1 - t0));
+    }
+
+    const int64_t d0 = now_ns();
+    if (s == Sink::Async) {
+        alog.stop();
+        res.dropped = alog.dropped();
+    }
+    if (f) std::fflush(f);
+    if (os.is_open()) os.flush();
+    res.drain_ms = (double)(now_ns() - d0) / 1e6;
+
+    if (f) std::fclose(f);
+    if (os.is_open()) os.close();
+    close(fd);
+    sink = sink + x;
+    res.stats = lat::compute_stats(std::move(samples));
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--out=", 0) == 0)             cfg.out = a.substr(6);
+        else if (a.rfind("--iters=", 0) == 0)      cfg.iters = std::max(1, std::atoi(a.c_str() + 8));
+        else if (a.rfind("--every=", 0) == 0)      cfg.every = std::max(1, std::atoi(a.c_str() + 8));
+        else if (a.rfind("--gap-ns=", 0) == 0)     cfg.gap_ns = std::max(0, std::atoi(a.c_str() + 9));
+        else if (a.rfind("--cpu=", 0) == 0)        cfg.cpu = std::atoi(a.c_str() + 6);
+        else if (a.rfind("--writer-cpu=", 0) == 0) cfg.writer_cpu = std::atoi(a.c_str() + 13);
+        else only = a;
+    }
+
+    const int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cfg.writer_cpu < 0) cfg.writer_cpu = ncpu > 1 ? ncpu - 1 : 0; // housekeeping: last CPU
+    cfg.writer_cpu %= std::max(1, ncpu);
+    pin_to(cfg.cpu);
+
+    std::printf("Hot-loop logging cost (ns per iteration, work + log call)\n");
+    std::printf("iters=%d  log every %d  gap=%d ns  hot cpu=%d  writer cpu=%d  out=%s\n",
+                cfg.iters, cfg.every, cfg.gap_ns, cfg.cpu % std::max(1, ncpu), cfg.writer_cpu,
+                cfg.out.c_str());
+    if (cfg.writer_cpu == cfg.cpu % std::max(1, ncpu))
+        std::printf("NOTE: writer shares the hot CPU (%d CPUs online); async tail includes preemption\n", ncpu);
+
+    std::printf("\n");
+    lat::print_table_header("sink", 12);
+    std::vector<std::pair<Sink, Result>> rows;
+    const Sink sinks[] = {Sink::None, Sink::Async, Sink::Printf, Sink::Iostream, Sink::Write};
+    for (Sink s : sinks) {
+        if (!only.empty() && only != sink_name(s)) continue;
+        Result r;
+        if (!run_sink(s, cfg, r)) continue;
+        lat::print_table_row(sink_name(s), r.stats, 12);
+        rows.emplace_back(s, r);
+    }
+
+    std::printf("\n%-10s %12s %12s\n", "sink", "dropped", "drain ms");
+    for (const auto& [s, r] : rows)
+        std::printf("%-10s %12llu %12.2f\n", sink_name(s), (unsigned long long)r.dropped, r.drain_ms);
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  Subtract 'none' to get the logging cost; compare p99/p99.9, not p50.\n");
+    std::printf("  printf/iostream max = the line that triggered write(); write pays it every line.\n");
+    std::printf("  async dropped > 0 means the writer could not keep up: raise --gap-ns or give it a core.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
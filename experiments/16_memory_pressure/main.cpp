@@ -0,0 +1,611 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// `latency pagefault` measures first-touch faults on an idle machine.
+// Here the measured process faults in a fresh REGION while another
+// process keeps the memory subsystem under pressure:
+//
+//   idle      no pressure: the reference distribution
+//   reclaim   a child fills the page cache (a file, read in) until only
+//             HEADROOM MB stay free: our faults must reclaim clean
+//             cache first (kswapd, then direct reclaim)
+//   fragment  a child allocates nearly all free memory, then frees
+//             every other 4 KB page: plenty of free memory, but no
+//             free 2 MB block -> huge page faults must compact
+//
+// "Free" is the lower of MemAvailable and the memory cgroup's limit
+// minus its usage, so the same run works inside a container.
+//
+// Per scenario, two rows:
+//   4k   one sample = first write to one 4 KB page
+//   thp  region madvise(MADV_HUGEPAGE); one sample = first write to
+//        one 2 MB chunk (a huge page fault, or a 4 KB fallback)
+// Each row gets a fresh pressure child, and reports the /proc/vmstat
+// deltas that explain it.
+//
+// THEORY:
+// - a fault normally takes a page from the per-CPU free lists: ~1 us
+//   (mostly zeroing). Below the low watermark the faulting thread
+//   reclaims pages itself: direct reclaim, tens of us to ms.
+// - a THP fault needs a free order-9 block. With defrag=madvise (the
+//   default) an MADV_HUGEPAGE region compacts synchronously to get
+//   one: migrating up to 512 pages, ms per fault.
+// - none of this shows in an idle benchmark.
+//
+// SOAK (`soak`): the THP problems that take minutes to appear. Keep a
+// WS MB working set of CHUNK MB mappings; forever replace a random
+// chunk (munmap, mmap, first-touch every 4 KB page, each timed) and
+// time random reads over the whole set. Once a second print the
+// touch / read tails, AnonHugePages from /proc/self/smaps_rollup and
+// the THP vmstat deltas, so a spike can be matched to its cause:
+// - a fault that compacts (compact_stall) under enabled/defrag;
+// - khugepaged collapsing 4 KB pages into a huge page behind our
+//   back (thp_collapse_alloc, AnonHugePages rising): it copies 2 MB
+//   and rewrites our page tables while holding the mmap lock.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static constexpr size_t PAGE = 4096;
+static constexpr size_t HUGE = 2u << 20;
+
+static inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+static long long read_ll(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) return -1;
+    long long v = -1;
+    if (std::fscanf(f, "%lld", &v) != 1) v = -1;
+    std::fclose(f);
+    return v;
+}
+
+static std::string read_line(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) return "?";
+    char buf[256] = {};
+    if (!std::fgets(buf, sizeof(buf), f)) buf[0] = '\0';
+    std::fclose(f);
+    std::string s = buf;
+    while (!s.empty() && s.back() == '\n') s.pop_back();
+    return s;
+}
+
+static bool write_str(const std::string& path, const std::string& v) {
+    const int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = write(fd, v.data(), v.size()) == (ssize_t)v.size();
+    close(fd);
+    return ok;
+}
+
+static long meminfo_kb(const char* want) {
+    FILE* f = std::fopen("/proc/meminfo", "r");
+    if (!f) return -1;
+    char key[64];
+    long v = 0, out = -1;
+    while (std::fscanf(f, "%63s %ld%*[^\n]", key, &v) == 2) {
+        if (!std::strcmp(key, want)) out = v;
+    }
+    std::fclose(f);
+    return out;
+}
+
+// Room left in our memory cgroup (v2 memory.max or v1 limit_in_bytes),
+// in bytes; -1 if unlimited or unknown.
+static long long cgroup_room() {
+    FILE* f = std::fopen("/proc/self/cgroup", "r");
+    if (!f) return -1;
+    char line[512];
+    std::string v1, v2;
+    while (std::fgets(line, sizeof(line), f)) {
+        std::string s = line;
+        while (!s.empty() && s.back() == '\n') s.pop_back();
+        if (s.rfind("0::", 0) == 0) v2 = s.substr(3);
+        const size_t m = s.find(":memory:");
+        if (m != std::string::npos) v1 = s.substr(m + 8);
+    }
+    std::fclose(f);
+    long long limit = -1, usage = -1;
+    if (!v1.empty()) {
+        limit = read_ll("/sys/fs/cgroup/memory" + v1 + "/memory.limit_in_bytes");
+        usage = read_ll("/sys/fs/cgroup/memory" + v1 + "/memory.usage_in_bytes");
+    } else if (!v2.empty()) {
+        limit = read_ll("/sys/fs/cgroup" + v2 + "/memory.max"); // "max" reads as -1
+        usage = read_ll("/sys/fs/cgroup" + v2 + "/memory.current");
+    }
+    if (limit <= 0 || usage < 0 || limit >= (1LL << 60)) return -1;
+    return std::max(0LL, limit - usage);
+}
+
+static size_t free_budget() {
+    long long room = (long long)meminfo_kb("MemAvailable:") * 1024;
+    const long long cg = cgroup_room();
+    if (cg >= 0 && cg < room) room = cg;
+    return room > 0 ? (size_t)room : 0;
+}
+
+// ---- /proc/vmstat counters that explain a slow fault -------------------
+
+struct VmStat {
+    long long pgscan_kswapd = 0, pgscan_direct = 0, allocstall = 0, compact_stall = 0, compact_fail = 0;
+    long long thp_alloc = 0, thp_fallback = 0, thp_collapse = 0;
+};
+
+static VmStat read_vmstat() {
+    VmStat v;
+    FILE* f = std::fopen("/proc/vmstat", "r");
+    if (!f) return v;
+    char key[128];
+    long long n = 0;
+    while (std::fscanf(f, "%127s %lld", key, &n) == 2) {
+        const std::string k = key;
+        if (k == "pgscan_kswapd") v.pgscan_kswapd = n;
+        else if (k == "pgscan_direct") v.pgscan_direct = n;
+        else if (k.rfind("allocstall_", 0) == 0) v.allocstall += n;
+        else if (k == "compact_stall") v.compact_stall = n;
+        else if (k == "compact_fail") v.compact_fail = n;
+        else if (k == "thp_fault_alloc") v.thp_alloc = n;
+        else if (k == "thp_fault_fallback") v.thp_fallback = n;
+        else if (k == "thp_collapse_alloc") v.thp_collapse = n;
+    }
+    std::fclose(f);
+    return v;
+}
+
+static VmStat operator-(const VmStat& a, const VmStat& b) {
+    return {a.pgscan_kswapd - b.pgscan_kswapd, a.pgscan_direct - b.pgscan_direct, a.allocstall - b.allocstall,
+            a.compact_stall - b.compact_stall, a.compact_fail - b.compact_fail,
+            a.thp_alloc - b.thp_alloc, a.thp_fallback - b.thp_fallback, a.thp_collapse - b.thp_collapse};
+}
+
+// "AnonHugePages:" from /proc/self/smaps_rollup, in KB.
+static long anon_huge_kb() {
+    FILE* f = std::fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (std::fgets(line, sizeof(line), f)) {
+        if (std::sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) break;
+    }
+    std::fclose(f);
+    return kb;
+}
+
+// Writes a sysfs knob for the run and puts the old value back on exit,
+// including on SIGINT / SIGTERM (see restore_and_exit): a soak is
+// usually ended with Ctrl-C, which would skip the destructor.
+// THP files read "a [b] c": the bracketed word is the one to restore.
+struct SysfsOverride {
+    std::string path, before, restore;
+    bool        active = false;
+
+    bool set(const std::string& p, const std::string& value);
+
+    ~SysfsOverride();
+};
+
+// Everything the signal handler needs, fixed before it is installed.
+static SysfsOverride* g_overrides[3];
+static int            g_n_overrides = 0;
+
+bool SysfsOverride::set(const std::string& p, const std::string& value) {
+    path = p;
+    before = read_line(p);
+    const size_t l = before.find('['), r = before.find(']');
+    restore = l != std::string::npos && r != std::string::npos ? before.substr(l + 1, r - l - 1) : before;
+    if (!write_str(p, value)) {
+        std::printf("cannot set %s to '%s' (%s); keeping '%s'\n", p.c_str(), value.c_str(),
+                    std::strerror(errno), before.c_str());
+        return false;
+    }
+    active = true;
+    if (g_n_overrides < 3) g_overrides[g_n_overrides++] = this;
+    std::printf("changed %s (was '%s'); if the run dies, restore with: echo %s > %s\n", p.c_str(),
+                restore.c_str(), restore.c_str(), p.c_str());
+    return true;
+}
+
+SysfsOverride::~SysfsOverride() {
+    if (!active) return;
+    active = false;
+    write_str(path, restore);
+}
+
+// Async-signal-safe: open/write/close on strings built before the
+// handler was installed, then _exit.
+static void restore_and_exit(int sig) {
+    for (int i = 0; i < g_n_overrides; i++) {
+        const SysfsOverride& o = *g_overrides[i];
+        if (!o.active) continue;
+        const int fd = open(o.path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        const ssize_t w = write(fd, o.restore.data(), o.restore.size());
+        (void)w;
+        close(fd);
+    }
+    _exit(128 + sig);
+}
+
+// ---- pressure child ----------------------------------------------------
+
+enum class Pressure { Idle, Reclaim, Fragment };
+
+static const char* pressure_name(Pressure p) {
+    switch (p) {
+        case Pressure::Idle:     return "idle";
+        case Pressure::Reclaim:  return "reclaim";
+        case Pressure::Fragment: return "fragment";
+    }
+    return "?";
+}
+
+struct Config {
+    size_t      region = 1024u << 20;
+    size_t      headroom = 128u << 20;
+    std::string dir = ".";
+    std::string defrag;  // THP knobs; empty: leave the system setting alone
+    std::string enabled;
+    std::string scan_ms; // khugepaged/scan_sleep_millisecs
+
+    // soak
+    int         seconds = 60;
+    size_t      ws = 512u << 20;
+    size_t      chunk = 4u << 20;
+    int         reads = 256;
+    int         gap_us = 2000;
+    int         spike_us = 1000;
+    bool        madv_huge = false;
+    std::string soak_pressure = "idle";
+};
+
+[[noreturn]] static void pressure_child(Pressure p, const Config& cfg, int ready_fd) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    const size_t budget = free_budget();
+    char ok = 1;
+
+    if (p == Pressure::Reclaim) {
+        // Clean page cache: fallocate'd extents read back (no disk I/O),
+        // pinned only by our open fd, reclaimable at any time.
+        const size_t bytes = budget > cfg.headroom ? budget - cfg.headroom : 0;
+        const std::string path = cfg.dir + "/lat_pressure.bin";
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd >= 0) unlink(path.c_str());
+        if (fd < 0 || posix_fallocate(fd, 0, (off_t)bytes) != 0) {
+            ok = 0;
+        } else {
+            std::vector<char> buf(1u << 20);
+            for (size_t off = 0; off < bytes; off += buf.size()) {
+                if (pread(fd, buf.data(), buf.size(), (off_t)off) <= 0) break;
+            }
+        }
+    } else if (p == Pressure::Fragment) {
+        // Everything except the headroom, then free every other page: the
+        // region has to come out of the holes. Anonymous, so it stays
+        // (no swap) but can be migrated.
+        const size_t want = budget > cfg.headroom ? budget - cfg.headroom : 0;
+        const size_t bytes = want / PAGE * PAGE;
+        char* m = bytes ? static_cast<char*>(mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))
+                        : nullptr;
+        if (m == MAP_FAILED || !m) {
+            ok = 0;
+        } else {
+            madvise(m, bytes, MADV_NOHUGEPAGE); // 4 KB pages, or the holes would be 2 MB
+            for (size_t off = 0; off < bytes; off += PAGE) m[off] = 1;
+            for (size_t off = PAGE; off < bytes; off += 2 * PAGE) madvise(m + off, PAGE, MADV_DONTNEED);
+        }
+    }
+
+    sink = sink + (uint64_t)write(ready_fd, &ok, 1);
+    close(ready_fd);
+    for (;;) pause();
+}
+
+struct Child {
+    pid_t pid = -1;
+};
+
+// Returns false if the child could not build its pressure.
+static bool start_pressure(Pressure p, const Config& cfg, Child& c) {
+    if (p == Pressure::Idle) return true;
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    std::fflush(stdout);
+    c.pid = fork();
+    if (c.pid == 0) {
+        std::signal(SIGINT, SIG_DFL); // the parent restores the THP knobs
+        std::signal(SIGTERM, SIG_DFL);
+        close(fds[0]);
+        pressure_child(p, cfg, fds[1]);
+    }
+    close(fds[1]);
+    char ok = 0;
+    if (c.pid < 0 || read(fds[0], &ok, 1) != 1) ok = 0;
+    close(fds[0]);
+    return ok == 1;
+}
+
+static void stop_pressure(Child& c) {
+    if (c.pid <= 0) return;
+    kill(c.pid, SIGKILL);
+    waitpid(c.pid, nullptr, 0);
+    c.pid = -1;
+}
+
+// ---- measured faults ---------------------------------------------------
+
+static std::vector<uint64_t> touch_region(const Config& cfg, bool thp) {
+    std::vector<uint64_t> samples;
+    // Over-allocate by 2 MB so the THP rows can start on a 2 MB boundary.
+    const size_t len = cfg.region + HUGE;
+    char* raw = static_cast<char*>(mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+    if (raw == MAP_FAILED) return samples;
+    char* p = reinterpret_cast<char*>(((uintptr_t)raw + HUGE - 1) & ~(uintptr_t)(HUGE - 1));
+    madvise(p, cfg.region, thp ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+
+    const size_t step = thp ? HUGE : PAGE;
+    samples.reserve(cfg.region / step);
+    for (size_t off = 0; off < cfg.region; off += step) {
+        const int64_t t0 = now_ns();
+        p[off] = 1;
+        const int64_t t1 = now_ns();
+        samples.push_back((uint64_t)(t1 - t0));
+    }
+    sink = sink + (uint64_t)p[0];
+    munmap(raw, len);
+    return samples;
+}
+
+static void print_row(const char* scen, const char* kind, const lat::Stats& s, const VmStat& d) {
+    std::printf("%-9s %-4s %7zu %8llu %9llu %10llu %10llu %9lld %9lld %9lld %8lld %8lld %8lld %8lld\n",
+                scen, kind, s.n, (unsigned long long)s.p50, (unsigned long long)s.p99,
+                (unsigned long long)s.p999, (unsigned long long)s.max, d.pgscan_kswapd, d.allocstall,
+                d.pgscan_direct,
+                d.compact_stall, d.compact_fail, d.thp_alloc, d.thp_fallback);
+}
+
+// ---- soak: churn a working set for minutes, watch THP over time --------
+
+static char* map_chunk(size_t bytes, bool madv_huge) {
+    // 2 MB aligned, so THP (fault or khugepaged) is possible everywhere.
+    char* raw = static_cast<char*>(mmap(nullptr, bytes + HUGE, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+    if (raw == MAP_FAILED) return nullptr;
+    char* p = reinterpret_cast<char*>(((uintptr_t)raw + HUGE - 1) & ~(uintptr_t)(HUGE - 1));
+    if (p > raw) munmap(raw, (size_t)(p - raw));
+    if (p + bytes < raw + bytes + HUGE) munmap(p + bytes, (size_t)(raw + bytes + HUGE - (p + bytes)));
+    if (madv_huge) madvise(p, bytes, MADV_HUGEPAGE);
+    return p;
+}
+
+static int run_soak(const Config& cfg) {
+    const size_t nchunks = std::max<size_t>(1, cfg.ws / cfg.chunk);
+    std::vector<char*> live(nchunks, nullptr);
+    for (auto& c : live) {
+        c = map_chunk(cfg.chunk, cfg.madv_huge);
+        if (!c) {
+            std::printf("mmap failed\n");
+            return 1;
+        }
+        for (size_t off = 0; off < cfg.chunk; off += PAGE) c[off] = 1;
+    }
+
+    // Histograms, not sample vectors: a soak can run for hours, and
+    // growing vectors would allocate inside the churn loop and show up
+    // as our own THP in AnonHuge. All four exist (and are zeroed) now.
+    const uint64_t spike_ns = (uint64_t)cfg.spike_us * 1000;
+    auto hist = std::make_unique<lat::LogHistogram[]>(4);
+    lat::LogHistogram& faults = hist[0];
+    lat::LogHistogram& reads = hist[1];
+    lat::LogHistogram& all_faults = hist[2];
+    lat::LogHistogram& all_reads = hist[3];
+    uint64_t rng = 0x9E3779B97F4A7C15ULL, spikes = 0, spikes_total = 0;
+    VmStat prev = read_vmstat();
+
+    std::printf("\n%5s %8s %8s %9s %10s %8s %9s %7s %9s %7s %7s %7s %8s\n",
+                "sec", "touches", "t_p50", "t_p99", "t_max", "r_p99", "r_max", "spikes",
+                "AnonHuge", "thp_ok", "thp_fb", "cmp_stl", "collapse");
+
+    const int64_t start = now_ns();
+    int64_t next_report = start + 1'000'000'000;
+    for (int sec = 1; sec <= cfg.seconds;) {
+        // Replace one chunk: munmap, mmap, first-touch every page.
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        char*& c = live[rng % nchunks];
+        munmap(c, cfg.chunk);
+        c = map_chunk(cfg.chunk, cfg.madv_huge);
+        if (!c) {
+            std::printf("mmap failed\n");
+            return 1;
+        }
+        for (size_t off = 0; off < cfg.chunk; off += PAGE) {
+            const int64_t t0 = now_ns();
+            c[off] = 1;
+            const int64_t t1 = now_ns();
+            faults.add((uint64_t)(t1 - t0));
+            all_faults.add((uint64_t)(t1 - t0));
+            spikes += (uint64_t)(t1 - t0) > spike_ns;
+        }
+        // Random reads over the whole set: TLB reach, and stalls while
+        // khugepaged rewrites the page tables under us.
+        for (int k = 0; k < cfg.reads; k++) {
+            rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+            const char* q = live[rng % nchunks] + (rng >> 20) % (cfg.chunk / 64) * 64;
+            const int64_t t0 = now_ns();
+            sink = sink + (uint64_t)*q;
+            const int64_t t1 = now_ns();
+            reads.add((uint64_t)(t1 - t0));
+            all_reads.add((uint64_t)(t1 - t0));
+            spikes += (uint64_t)(t1 - t0) > spike_ns;
+        }
+        if (cfg.gap_us > 0) usleep((useconds_t)cfg.gap_us);
+
+        if (now_ns() < next_report) continue;
+        const VmStat now = read_vmstat();
+        const VmStat d = now - prev;
+        prev = now;
+        spikes_total += spikes;
+        const lat::Stats f = faults.stats();
+        const lat::Stats r = reads.stats();
+        std::printf("%5d %8zu %8llu %9llu %10llu %8llu %9llu %7llu %6ld MB %7lld %7lld %7lld %8lld\n",
+                    sec, f.n, (unsigned long long)f.p50, (unsigned long long)f.p99,
+                    (unsigned long long)f.max, (unsigned long long)r.p99, (unsigned long long)r.max,
+                    (unsigned long long)spikes, anon_huge_kb() / 1024, d.thp_alloc, d.thp_fallback,
+                    d.compact_stall, d.thp_collapse);
+        std::fflush(stdout);
+        faults.clear();
+        reads.clear();
+        spikes = 0;
+        next_report += 1'000'000'000;
+        sec++;
+    }
+
+    std::printf("\n");
+    lat::print_table_header("whole run", 12);
+    lat::print_table_row("touch", all_faults.stats(), 12);
+    lat::print_table_row("read", all_reads.stats(), 12);
+    std::printf("spikes > %d us: %llu\n", cfg.spike_us, (unsigned long long)spikes_total);
+
+    for (char* c : live) munmap(c, cfg.chunk);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--region-mb=", 0) == 0)        cfg.region = (size_t)std::max(4, std::atoi(a.c_str() + 12)) << 20;
+        else if (a.rfind("--headroom-mb=", 0) == 0) cfg.headroom = (size_t)std::max(0, std::atoi(a.c_str() + 14)) << 20;
+        else if (a.rfind("--dir=", 0) == 0)         cfg.dir = a.substr(6);
+        else if (a.rfind("--defrag=", 0) == 0)      cfg.defrag = a.substr(9);
+        else if (a.rfind("--enabled=", 0) == 0)     cfg.enabled = a.substr(10);
+        else if (a.rfind("--scan-ms=", 0) == 0)     cfg.scan_ms = a.substr(10);
+        else if (a.rfind("--seconds=", 0) == 0)     cfg.seconds = std::max(1, std::atoi(a.c_str() + 10));
+        else if (a.rfind("--ws-mb=", 0) == 0)       cfg.ws = (size_t)std::max(4, std::atoi(a.c_str() + 8)) << 20;
+        else if (a.rfind("--chunk-mb=", 0) == 0)    cfg.chunk = (size_t)std::max(2, std::atoi(a.c_str() + 11)) << 20;
+        else if (a.rfind("--reads=", 0) == 0)       cfg.reads = std::max(0, std::atoi(a.c_str() + 8));
+        else if (a.rfind("--gap-us=", 0) == 0)      cfg.gap_us = std::max(0, std::atoi(a.c_str() + 9));
+        else if (a.rfind("--spike-us=", 0) == 0)    cfg.spike_us = std::max(1, std::atoi(a.c_str() + 11));
+        else if (a.rfind("--pressure=", 0) == 0)    cfg.soak_pressure = a.substr(11);
+        else if (a == "--madvise")                  cfg.madv_huge = true;
+        else only = a;
+    }
+    cfg.region = cfg.region / HUGE * HUGE;
+    cfg.chunk = cfg.chunk / HUGE * HUGE;
+
+    const std::string thp_dir = "/sys/kernel/mm/transparent_hugepage/";
+    SysfsOverride enabled_o, defrag_o, scan_o;
+    if (!cfg.enabled.empty()) enabled_o.set(thp_dir + "enabled", cfg.enabled);
+    if (!cfg.defrag.empty()) defrag_o.set(thp_dir + "defrag", cfg.defrag);
+    if (!cfg.scan_ms.empty()) scan_o.set(thp_dir + "khugepaged/scan_sleep_millisecs", cfg.scan_ms);
+    if (g_n_overrides > 0) {
+        std::signal(SIGINT, restore_and_exit);
+        std::signal(SIGTERM, restore_and_exit);
+    }
+
+    const long long cg = cgroup_room();
+    const bool soak = only == "soak";
+    if (soak) {
+        std::printf("THP soak: %d s, working set %zu MB in %zu MB chunks%s, %d reads per chunk, gap %d us\n",
+                    cfg.seconds, cfg.ws >> 20, cfg.chunk >> 20, cfg.madv_huge ? " (MADV_HUGEPAGE)" : "",
+                    cfg.reads, cfg.gap_us);
+    } else {
+        std::printf("First-touch fault latency under memory pressure (ns per fault)\n");
+        std::printf("region=%zu MB  headroom=%zu MB  free budget=%zu MB (MemAvailable %ld MB, cgroup room %s)\n",
+                    cfg.region >> 20, cfg.headroom >> 20, free_budget() >> 20,
+                    meminfo_kb("MemAvailable:") / 1024,
+                    cg < 0 ? "unlimited" : (std::to_string(cg >> 20) + " MB").c_str());
+    }
+    std::printf("THP enabled: %s\nTHP defrag:  %s\nkhugepaged:  scan every %s ms, %s pages\n",
+                read_line(thp_dir + "enabled").c_str(), read_line(thp_dir + "defrag").c_str(),
+                read_line(thp_dir + "khugepaged/scan_sleep_millisecs").c_str(),
+                read_line(thp_dir + "khugepaged/pages_to_scan").c_str());
+
+    if (soak) {
+        Child c;
+        const Pressure p = cfg.soak_pressure == "reclaim"    ? Pressure::Reclaim
+                           : cfg.soak_pressure == "fragment" ? Pressure::Fragment
+                                                             : Pressure::Idle;
+        if (!start_pressure(p, cfg, c)) {
+            stop_pressure(c);
+            std::printf("could not build '%s' pressure\n", pressure_name(p));
+            return 1;
+        }
+        if (p != Pressure::Idle) std::printf("pressure: %s (headroom %zu MB)\n", pressure_name(p), cfg.headroom >> 20);
+        const int rc = run_soak(cfg);
+        stop_pressure(c);
+
+        std::printf("\nInterpretation:\n");
+        std::printf("  t_* = first touch of a page (ns), r_* = random read of live memory (ns).\n");
+        std::printf("  Seconds with cmp_stl > 0 and a ms t_max: direct compaction on the fault path.\n");
+        std::printf("  collapse > 0 with AnonHuge rising: khugepaged; watch r_max in those seconds.\n");
+        std::fflush(stdout);
+        std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+        return rc;
+    }
+
+    std::printf("\n%-9s %-4s %7s %8s %9s %10s %10s %9s %9s %9s %8s %8s %8s %8s\n",
+                "pressure", "page", "n", "p50", "p99", "p99.9", "max", "pgscan_k",
+                "allocstl", "pgscan_d", "cmp_stl", "cmp_fail", "thp_ok", "thp_fb");
+
+    const Pressure scenarios[] = {Pressure::Idle, Pressure::Reclaim, Pressure::Fragment};
+    for (Pressure p : scenarios) {
+        if (!only.empty() && only != pressure_name(p)) continue;
+        for (bool thp : {false, true}) {
+            Child c;
+            if (!start_pressure(p, cfg, c)) {
+                stop_pressure(c);
+                std::printf("%-9s %-4s  (could not build pressure; try --dir= or a smaller --region-mb)\n",
+                            pressure_name(p), thp ? "thp" : "4k");
+                continue;
+            }
+            const VmStat before = read_vmstat();
+            std::vector<uint64_t> samples = touch_region(cfg, thp);
+            const VmStat delta = read_vmstat() - before;
+            stop_pressure(c);
+            if (samples.empty()) {
+                std::printf("%-9s %-4s  (mmap failed)\n", pressure_name(p), thp ? "thp" : "4k");
+                continue;
+            }
+            print_row(pressure_name(p), thp ? "thp" : "4k", lat::compute_stats(std::move(samples)), delta);
+        }
+    }
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  pgscan_k > 0: kswapd reclaimed in the background; allocstl/pgscan_d > 0: our\n");
+    std::printf("  faults reclaimed themselves (direct reclaim). Compare 4k p99.9 with idle.\n");
+    std::printf("  cmp_stl > 0: THP faults compacted synchronously (defrag); thp_fb: gave up, 4 KB page.\n");
+    std::printf("  Vmstat counters are system-wide: other processes add to them.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <alloca.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/stats.hpp"
+
+// ------------------------------------------------------------
+// PURPOSE
+// ------------------------------------------------------------
+// A thread's stack is lazily faulted like any other anonymous memory.
+// The hot path is shallow almost always; once in a while it takes a
+// rare, deeper path (an error branch, a big local buffer, recursion on
+// an unusual input) and reaches stack pages never touched before.
+// Each such page is a page fault ON the hot path.
+//
+// A worker thread runs ITERS iterations of a tiny op. Every EVERY
+// iterations it takes an "event": a call that uses a little more
+// stack than any event before it (up to MAX_STACK), so every event
+// touches about one fresh 4 KB page:
+//
+//   recurse   recursion through 4 KB frames (one level per page)
+//   frame     one frame with an alloca'd buffer, written every 4 KB
+//
+// Stack variants (each row runs in a fresh forked process, so glibc's
+// cache of freed thread stacks cannot hand us pre-faulted memory):
+//
+//   default    std::thread-like pthread_create, default stack
+//   mlockcur   mlockall(MCL_CURRENT) before the thread is created: the
+//              usual "lock memory at startup" advice
+//   mlockall   mlockall(MCL_CURRENT | MCL_FUTURE) before the thread
+//   pretouch   default stack; the thread writes MAX_STACK + margin of
+//              its own stack (one alloca) before the loop
+//   mmap       stack from mmap(MAP_POPULATE | MAP_STACK) + mlock, with
+//              a guard page, passed via pthread_attr_setstack
+//
+// One sample = ns per iteration; the event columns are what matter.
+// Sample buffers are written once before the loop so that the only
+// faults left inside it are the stack's.
+//
+// THEORY:
+// - a fresh stack page costs a minor fault: ~1-2 us of kernel entry,
+//   page allocation and zeroing, more under memory pressure.
+// - MCL_CURRENT locks what is mapped NOW; a thread stack mmap'd later
+//   is not covered. MCL_FUTURE makes later mappings VM_LOCKED, which
+//   populates them at mmap time -- all 8 MB of every thread stack --
+//   unless glibc reuses a cached stack mapped before the call.
+// - pretouch and a populated stack move all those faults to startup.
+// ------------------------------------------------------------
+
+volatile uint64_t sink = 0;
+
+static constexpr size_t PAGE = 4096;
+
+static void pin_to(int cpu) {
+    const int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+enum class Shape { Recurse, Frame };
+enum class Stack { Default, Mlockcur, Mlockall, Pretouch, Mmap };
+
+static const char* shape_name(Shape s) { return s == Shape::Recurse ? "recurse" : "frame"; }
+
+static const char* stack_name(Stack s) {
+    switch (s) {
+        case Stack::Default:  return "default";
+        case Stack::Mlockcur: return "mlockcur";
+        case Stack::Mlockall: return "mlockall";
+        case Stack::Pretouch: return "pretouch";
+        case Stack::Mmap:     return "mmap";
+    }
+    return "?";
+}
+
+struct Config {
+    int    iters = 200'000;
+    int    events = 256;
+    size_t max_stack = 1u << 20;
+    int    cpu = 0;
+};
+
+// ---- the rare deep paths -----------------------------------------------
+
+static constexpr size_t FRAME = PAGE;
+
+__attribute__((noinline)) static uint64_t recurse(int n) {
+    volatile char pad[FRAME];
+    pad[0] = (char)n;
+    pad[FRAME - 1] = (char)n;
+    if (n <= 0) return (uint64_t)pad[0];
+    return recurse(n - 1) + (uint64_t)pad[FRAME - 1]; // not a tail call
+}
+
+__attribute__((noinline)) static uint64_t big_frame(size_t bytes) {
+    volatile char* p = static_cast<volatile char*>(alloca(bytes));
+    // Top down, like a callee walking into its buffer from the frame.
+    for (size_t off = bytes; off >= PAGE; off -= PAGE) p[off - 1] = 1;
+    p[0] = 1;
+    return (uint64_t)p[bytes / 2];
+}
+
+static uint64_t deep_path(Shape s, size_t bytes) {
+    if (s == Shape::Recurse) return recurse((int)(bytes / FRAME));
+    return big_frame(bytes);
+}
+
+// ---- worker --------------------------------------------------------------
+
+struct Work {
+    Config                cfg;
+    Shape                 shape;
+    Stack                 stack;
+    std::vector<uint64_t> all, events;
+    long                  minflt = 0;
+};
+
+static void* worker(void* arg) {
+    Work& w = *static_cast<Work*>(arg);
+    pin_to(w.cfg.cpu);
+
+    // Margin for the frames above the loop and the recursion overhead
+    // (return address, saved registers) beyond the 4 KB pads.
+    if (w.stack == Stack::Pretouch) sink = sink + big_frame(w.cfg.max_stack + w.cfg.max_stack / 4 + 64 * 1024);
+
+    const int every = std::max(1, w.cfg.iters / w.cfg.events);
+    const size_t n_events = (size_t)(w.cfg.iters + every - 1) / every;
+    w.all.assign(w.cfg.iters, 0);
+    w.events.assign(n_events, 0);
+    size_t e = 0;
+    uint64_t x = 1;
+
+    rusage r0;
+    getrusage(RUSAGE_THREAD, &r0);
+    for (int i = 0; i < w.cfg.iters; i++) {
+        const bool event = i % every == 0;
+        const size_t depth = std::min(w.cfg.max_stack, (size_t)(i / every + 1) * w.cfg.max_stack / w.cfg.events);
+
+        const int64_t t0 = now_ns();
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        if (event) x += deep_path(w.shape, depth);
+        const int64_t t1 = now_ns();
+
+        w.all[i] = (uint64_t)(t1 - t0);
+        if (event) w.events[e++] = (uint64_t)(t1 - t0);
+    }
+    rusage r1;
+    getrusage(RUSAGE_THREAD, &r1);
+    w.minflt = r1.ru_minflt - r0.ru_minflt;
+    sink = sink + x;
+    return nullptr;
+}
+
+// Runs in a forked child: one process per row keeps glibc's stack
+// cache and mlockall() state from leaking between rows.
+static int run_row(const Config& cfg, Shape shape, Stack stack) {
+    Work w{cfg, shape, stack, {}, {}, 0};
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    void* mem = nullptr;
+    size_t mem_len = 0;
+
+    const int lock_flags = stack == Stack::Mlockcur ? MCL_CURRENT
+                           : stack == Stack::Mlockall ? MCL_CURRENT | MCL_FUTURE
+                                                      : 0;
+    if (lock_flags && mlockall(lock_flags) != 0) {
+        std::printf("%-9s %-8s  (mlockall: %s)\n", stack_name(stack), shape_name(shape), std::strerror(errno));
+        return 1;
+    }
+    if (stack == Stack::Mmap) {
+        // 8 MB like the default, populated and locked; lowest page is the guard.
+        mem_len = 8u << 20;
+        mem = mmap(nullptr, mem_len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_POPULATE, -1, 0);
+        if (mem == MAP_FAILED) {
+            std::printf("%-9s %-8s  (mmap: %s)\n", stack_name(stack), shape_name(shape), std::strerror(errno));
+            return 1;
+        }
+        if (mlock(mem, mem_len) != 0)
+            std::printf("NOTE: mlock failed (%s); stack is populated but not locked\n", std::strerror(errno));
+        mprotect(mem, PAGE, PROT_NONE);
+        pthread_attr_setstack(&attr, mem, mem_len);
+    }
+
+    pthread_t t;
+    if (const int e = pthread_create(&t, &attr, worker, &w); e != 0) {
+        std::printf("%-9s %-8s  (pthread_create: %s)\n", stack_name(stack), shape_name(shape), std::strerror(e));
+        return 1;
+    }
+    pthread_join(t, nullptr);
+    pthread_attr_destroy(&attr);
+    if (mem) munmap(mem, mem_len);
+
+    const lat::Stats a = lat::compute_stats(std::move(w.all));
+    const lat::Stats e = lat::compute_stats(std::move(w.events));
+    std::printf("%-9s %-8s %7zu %9llu %9llu %10llu %10llu %11llu %8ld\n",
+                stack_name(stack), shape_name(shape), e.n, (unsigned long long)e.p50,
+                (unsigned long long)e.p99, (unsigned long long)e.max, (unsigned long long)a.p999,
+                (unsigned long long)a.max, w.minflt);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    std::string only;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a.rfind("--iters=", 0) == 0)             cfg.iters = std::max(1, std::atoi(a.c_str() + 8));
+        else if (a.rfind("--events=", 0) == 0)       cfg.events = std::max(1, std::atoi(a.c_str() + 9));
+        else if (a.rfind("--max-stack-kb=", 0) == 0) cfg.max_stack = (size_t)std::clamp(std::atoi(a.c_str() + 15), 4, 4096) << 10;
+        else if (a.rfind("--cpu=", 0) == 0)          cfg.cpu = std::atoi(a.c_str() + 6);
+        else only = a;
+    }
+
+    rlimit rl{};
+    getrlimit(RLIMIT_MEMLOCK, &rl);
+    std::printf("Stack page faults on the hot path (ns per iteration)\n");
+    std::printf("iters=%d  events=%d (one every %d iterations)  deepest event=%zu KB  RLIMIT_MEMLOCK=%s\n",
+                cfg.iters, cfg.events, std::max(1, cfg.iters / cfg.events), cfg.max_stack >> 10,
+                rl.rlim_cur == RLIM_INFINITY ? "unlimited" : (std::to_string(rl.rlim_cur >> 10) + " KB").c_str());
+    std::printf("\n%-9s %-8s %7s %9s %9s %10s %10s %11s %8s\n",
+                "stack", "shape", "events", "ev p50", "ev p99", "ev max", "all p99.9", "all max", "minflt");
+
+    const Stack stacks[] = {Stack::Default, Stack::Mlockcur, Stack::Mlockall, Stack::Pretouch, Stack::Mmap};
+    for (Stack st : stacks) {
+        if (!only.empty() && only != stack_name(st)) continue;
+        for (Shape sh : {Shape::Recurse, Shape::Frame}) {
+            std::fflush(stdout);
+            const pid_t pid = fork();
+            if (pid == 0) {
+                const int rc = run_row(cfg, sh, st);
+                std::fflush(stdout);
+                _exit(rc);
+            }
+            if (pid > 0) waitpid(pid, nullptr, 0);
+        }
+    }
+
+    std::printf("\nInterpretation:\n");
+    std::printf("  minflt = page faults taken by the worker inside the measured loop.\n");
+    std::printf("  default: ~1 fault per event, ev p50 = one fault. A fix must bring minflt to ~0.\n");
+    std::printf("  mlockcur misses stacks created later; mlockall(MCL_FUTURE) locks every whole stack.\n");
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "sink=%llu\n", (unsigned long long)sink);
+    return 0;
+}
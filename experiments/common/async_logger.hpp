@@ -0,0 +1,289 @@
+#pragma once
+
+// ------------------------------------------------------------
+// Binary asynchronous logger for latency-critical threads.
+// ------------------------------------------------------------
+// Hot path (log()): copy the format pointer, a formatter function
+// pointer, a timestamp and up to MAX_ARGS raw 8-byte arguments into
+// this thread's SPSC ring. No formatting, no locks, no syscalls,
+// no allocation once the thread's ring exists (see prepare()).
+//
+// Writer thread (ideally on a housekeeping core): drains every ring,
+// formats with snprintf into its own 1 MB buffer and fwrite()s it to
+// the FILE* when full (and on stop). The stream's buffering mode is
+// never touched, so stdout stays line-buffered and other threads may
+// keep using the same FILE* (stdio locks each call).
+//
+//   lat::AsyncLogger log(file, /*writer_cpu=*/0);
+//   log.start();
+//   log.prepare();   // on each logging thread, before its hot loop
+//   log.log("fill id=%llu px=%.2f qty=%d\n", id, px, qty);
+//   log.stop();   // drains and flushes
+//
+// Rules:
+// - fmt must be a string literal (only the pointer is stored);
+// - arguments: integers, floating point, pointers, or const char* to
+//   STATIC strings; at most MAX_ARGS of them;
+// - a full ring DROPS the record and counts it: the hot path never waits;
+// - rings belong to the logger and are freed with it. Threads find theirs
+//   by the logger's id (never reused), not its address.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+namespace lat {
+
+class AsyncLogger {
+public:
+    static constexpr int    MAX_ARGS = 5;
+    static constexpr size_t RING_RECORDS = 1 << 14; // per thread, power of two
+
+    explicit AsyncLogger(FILE* out, int writer_cpu = -1)
+        : out_(out), writer_cpu_(writer_cpu), id_(next_id().fetch_add(1, std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> g(live_m());
+        live_ids().insert(id_);
+    }
+
+    ~AsyncLogger() {
+        stop();
+        std::lock_guard<std::mutex> g(live_m());
+        live_ids().erase(id_);
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Creates (and pre-faults) the calling thread's ring. Call it on every
+    // logging thread before its hot loop, or the first log() pays for a
+    // 1 MB allocation, a mutex and the page faults.
+    void prepare() { (void)my_ring(); }
+
+    void start() {
+        running_.store(true, std::memory_order_relaxed);
+        writer_ = std::thread([this] { writer_main(); });
+    }
+
+    // Drains everything logged before the call, then flushes.
+    void stop() {
+        if (!writer_.joinable()) return;
+        running_.store(false, std::memory_order_release);
+        writer_.join();
+        std::fflush(out_);
+    }
+
+    template <typename... Args>
+    void log(const char* fmt, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "too many log arguments");
+        static_assert((... && (std::is_trivially_copyable_v<Args> && sizeof(Args) <= 8)),
+                      "log arguments must be scalars (pass static strings as const char*)");
+        Ring& r = my_ring();
+        const uint64_t t = r.tail.load(std::memory_order_relaxed);
+        if (t - r.head.load(std::memory_order_acquire) >= RING_RECORDS) {
+            r.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Record& rec = r.slots[t & (RING_RECORDS - 1)];
+        rec.fmt = fmt;
+        rec.format = &format_record<Args...>;
+        rec.ts_ns = now_ns();
+        int i = 0;
+        (store_arg(rec.args[i++], args), ...);
+        r.tail.store(t + 1, std::memory_order_release);
+    }
+
+    uint64_t dropped() const {
+        std::lock_guard<std::mutex> g(rings_m_);
+        uint64_t d = 0;
+        for (const auto& r : rings_) d += r->dropped.load(std::memory_order_relaxed);
+        return d;
+    }
+
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+
+private:
+    struct Record {
+        const char* fmt;
+        int (*format)(char*, size_t, const Record&); // snprintf contract
+        int64_t  ts_ns;
+        uint64_t args[MAX_ARGS];
+    };
+
+    struct Ring {
+        alignas(64) std::atomic<uint64_t> head{0}; // writer thread
+        alignas(64) std::atomic<uint64_t> tail{0}; // owning thread
+        std::atomic<uint64_t> dropped{0};
+        std::unique_ptr<Record[]> slots{new Record[RING_RECORDS]()}; // zeroed: every page touched now
+    };
+
+    // Per thread: (logger id, ring) for every logger it has logged to.
+    struct TlsEntry {
+        uint64_t id;
+        Ring*    ring;
+    };
+
+    static std::atomic<uint64_t>& next_id() {
+        static std::atomic<uint64_t> id{1};
+        return id;
+    }
+    static std::mutex& live_m() {
+        static std::mutex m;
+        return m;
+    }
+    static std::unordered_set<uint64_t>& live_ids() {
+        static std::unordered_set<uint64_t> ids;
+        return ids;
+    }
+    static std::vector<TlsEntry>& tls_rings() {
+        thread_local std::vector<TlsEntry> v;
+        return v;
+    }
+
+    static int64_t now_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (int64_t)ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+    }
+
+    template <typename T>
+    static void store_arg(uint64_t& slot, T v) {
+        slot = 0;
+        std::memcpy(&slot, &v, sizeof(T));
+    }
+
+    template <typename T>
+    static T load_arg(uint64_t slot) {
+        T v;
+        std::memcpy(&v, &slot, sizeof(T));
+        return v;
+    }
+
+    // Instantiated per argument-type list: rebuilds the call to snprintf.
+    // Returns the full length, as snprintf does, even if cap cut it short.
+    template <typename... Args, size_t... I>
+    static int format_impl(char* dst, size_t cap, const Record& r, std::index_sequence<I...>) {
+        const int h = std::snprintf(dst, cap, "%lld.%09lld ", (long long)(r.ts_ns / 1'000'000'000),
+                                    (long long)(r.ts_ns % 1'000'000'000));
+        if (h < 0) return h;
+        const size_t used = std::min((size_t)h, cap);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+        const int b = std::snprintf(dst + used, cap - used, r.fmt, load_arg<Args>(r.args[I])...);
+#pragma GCC diagnostic pop
+        return b < 0 ? b : h + b;
+    }
+
+    template <typename... Args>
+    static int format_record(char* dst, size_t cap, const Record& r) {
+        return format_impl<Args...>(dst, cap, r, std::index_sequence_for<Args...>{});
+    }
+
+    // One ring per (logger, thread). The lookup is a scan of a vector
+    // with one entry per logger this thread uses: normally one.
+    Ring& my_ring() {
+        for (const TlsEntry& e : tls_rings()) {
+            if (e.id == id_) return *e.ring;
+        }
+        return add_ring();
+    }
+
+    // Slow path: forget rings of loggers that are gone (their memory was
+    // freed with them), then create ours.
+    Ring& add_ring() {
+        std::vector<TlsEntry>& v = tls_rings();
+        {
+            std::lock_guard<std::mutex> g(live_m());
+            std::erase_if(v, [](const TlsEntry& e) { return !live_ids().count(e.id); });
+        }
+        auto r = std::make_unique<Ring>();
+        Ring* ring = r.get();
+        {
+            std::lock_guard<std::mutex> g(rings_m_);
+            rings_.push_back(std::move(r));
+        }
+        v.push_back({id_, ring});
+        return *ring;
+    }
+
+    // Appends one formatted record to buf; hands buf to out_ when full.
+    void emit(const Record& rec, std::vector<char>& buf, size_t& pos) {
+        int n = rec.format(buf.data() + pos, buf.size() - pos, rec);
+        if (n < 0) return;
+        if ((size_t)n >= buf.size() - pos) { // no room (snprintf also needs the NUL)
+            flush_buf(buf, pos);
+            n = rec.format(buf.data(), buf.size(), rec);
+            if (n < 0) return;
+            n = std::min(n, (int)buf.size() - 1); // a record longer than buf is cut
+        }
+        pos += (size_t)n;
+    }
+
+    void flush_buf(const std::vector<char>& buf, size_t& pos) {
+        if (pos > 0) std::fwrite(buf.data(), 1, pos, out_);
+        pos = 0;
+    }
+
+    size_t drain_once(std::vector<char>& buf, size_t& pos) {
+        std::vector<Ring*> snapshot;
+        {
+            std::lock_guard<std::mutex> g(rings_m_);
+            for (auto& r : rings_) snapshot.push_back(r.get());
+        }
+        size_t n = 0;
+        for (Ring* r : snapshot) {
+            uint64_t h = r->head.load(std::memory_order_relaxed);
+            const uint64_t t = r->tail.load(std::memory_order_acquire);
+            for (; h != t; h++, n++) {
+                emit(r->slots[h & (RING_RECORDS - 1)], buf, pos);
+            }
+            r->head.store(h, std::memory_order_release);
+        }
+        written_.fetch_add(n, std::memory_order_relaxed);
+        return n;
+    }
+
+    void writer_main() {
+        if (writer_cpu_ >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(writer_cpu_, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        // Our own big buffer: one fwrite() per ~1 MB of text.
+        std::vector<char> buf(1 << 20);
+        size_t pos = 0;
+        while (running_.load(std::memory_order_acquire)) {
+            if (drain_once(buf, pos) == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        drain_once(buf, pos);
+        flush_buf(buf, pos);
+        std::fflush(out_);
+    }
+
+    FILE*             out_;
+    int               writer_cpu_;
+    const uint64_t    id_;
+    std::thread       writer_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> written_{0};
+
+    mutable std::mutex                 rings_m_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+} // namespace lat
@@ -0,0 +1,170 @@
+#pragma once
+
+// ------------------------------------------------------------
+// Shared percentile helpers for the experiments.
+// ------------------------------------------------------------
+// Same discipline as src/main.cpp:
+// - collect raw per-operation samples (ns) into a preallocated vector
+// - sort and summarise OFF the measured path
+// - report the tail, not just the mean
+//
+// Header-only so every experiment still builds from a single main.cpp:
+//   g++ -O2 -std=c++20 ... main.cpp
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace lat {
+
+inline uint64_t percentile_sorted(const std::vector<uint64_t>& sorted, double p) {
+    // "sorted" must be sorted ascending; p in [0, 1].
+    if (sorted.empty()) return 0;
+    if (p <= 0.0) return sorted.front();
+    if (p >= 1.0) return sorted.back();
+
+    const double idx = p * (sorted.size() - 1);
+    return sorted[static_cast<size_t>(idx)];
+}
+
+struct Stats {
+    size_t   n = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    double   avg = 0.0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+};
+
+inline Stats compute_stats(std::vector<uint64_t> samples) {
+    // Copy in so we can sort freely; done after measurement.
+    Stats s;
+    if (samples.empty()) return s;
+
+    std::sort(samples.begin(), samples.end());
+    s.n   = samples.size();
+    s.min = samples.front();
+    s.max = samples.back();
+
+    const long double sum = std::accumulate(samples.begin(), samples.end(),
+                                            (long double)0.0);
+    s.avg = (double)(sum / (long double)samples.size());
+
+    s.p50  = percentile_sorted(samples, 0.50);
+    s.p90  = percentile_sorted(samples, 0.90);
+    s.p99  = percentile_sorted(samples, 0.99);
+    s.p999 = percentile_sorted(samples, 0.999);
+    return s;
+}
+
+// Fixed-size log-linear histogram for runs too long to keep every
+// sample (soak tests). 32 sub-buckets per power of two: values below 64
+// are exact, larger ones are reported to within ~3%. No allocation, so
+// it can be filled inside the measured loop.
+struct LogHistogram {
+    static constexpr int SUB = 32;
+    static constexpr int BUCKETS = 60 * SUB;
+
+    uint64_t    counts[BUCKETS] = {};
+    uint64_t    n = 0;
+    uint64_t    min = UINT64_MAX;
+    uint64_t    max = 0;
+    long double sum = 0;
+
+    static int bucket(uint64_t v) {
+        if (v < SUB) return (int)v;
+        const int o = 63 - __builtin_clzll(v); // >= 5
+        return (o - 4) * SUB + (int)((v >> (o - 5)) - SUB);
+    }
+
+    // Largest value that lands in bucket i.
+    static uint64_t bucket_high(int i) {
+        if (i < SUB) return (uint64_t)i;
+        const int g = i / SUB;
+        return (((uint64_t)(SUB + i % SUB) + 1) << (g - 1)) - 1;
+    }
+
+    void add(uint64_t v) {
+        counts[bucket(v)]++;
+        n++;
+        sum += (long double)v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+
+    void clear() { *this = LogHistogram{}; }
+
+    // Same rank rule as percentile_sorted(); reports the bucket's upper edge.
+    uint64_t percentile(double p) const {
+        if (n == 0) return 0;
+        if (p <= 0.0) return min;
+        if (p >= 1.0) return max;
+        const uint64_t rank = (uint64_t)(p * (double)(n - 1));
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > rank) return std::clamp(bucket_high(i), min, max);
+        }
+        return max;
+    }
+
+    Stats stats() const {
+        Stats s;
+        if (n == 0) return s;
+        s.n = n;
+        s.min = min;
+        s.max = max;
+        s.avg = (double)(sum / (long double)n);
+        s.p50 = percentile(0.50);
+        s.p90 = percentile(0.90);
+        s.p99 = percentile(0.99);
+        s.p999 = percentile(0.999);
+        return s;
+    }
+};
+
+// Block format, identical to the main tool's print_stats().
+inline void print_stats(const char* title, const Stats& s) {
+    std::printf("%s\n", title);
+    std::printf("min:   %llu\n", (unsigned long long)s.min);
+    std::printf("avg:   %.2f\n", s.avg);
+    std::printf("p50:   %llu\n", (unsigned long long)s.p50);
+    std::printf("p90:   %llu\n", (unsigned long long)s.p90);
+    std::printf("p99:   %llu\n", (unsigned long long)s.p99);
+    std::printf("p99.9: %llu\n", (unsigned long long)s.p999);
+    std::printf("max:   %llu\n", (unsigned long long)s.max);
+}
+
+// Table format for sweeps: one row per configuration.
+inline void print_table_header(const char* label_title, int label_width = 28) {
+    std::printf("%-*s %8s %10s %10s %10s %10s %10s %12s %12s\n",
+                label_width, label_title,
+                "n", "min", "avg", "p50", "p90", "p99", "p99.9", "max");
+}
+
+inline void print_table_row(const std::string& label, const Stats& s, int label_width = 28) {
+    std::printf("%-*s %8zu %10llu %10.1f %10llu %10llu %10llu %12llu %12llu\n",
+                label_width, label.c_str(), s.n,
+                (unsigned long long)s.min, s.avg,
+                (unsigned long long)s.p50, (unsigned long long)s.p90,
+                (unsigned long long)s.p99, (unsigned long long)s.p999,
+                (unsigned long long)s.max);
+}
+
+// Human-readable byte sizes for sweep labels ("64B", "4KB", "64MB").
+inline std::string format_bytes(size_t bytes) {
+    const char* units[] = {"B", "KB", "MB", "GB"};
+    int u = 0;
+    while (u < 3 && bytes >= 1024 && bytes % 1024 == 0) {
+        bytes /= 1024;
+        u++;
+    }
+    return std::to_string(bytes) + units[u];
+}
+
+} // namespace lat
@@ -0,0 +1,176 @@
+#pragma once
+
+// ------------------------------------------------------------
+// Minimal io_uring wrapper on raw syscalls (no liburing needed).
+// ------------------------------------------------------------
+// Only what the experiments use:
+// - setup with optional SQPOLL, mmap of the SQ / CQ rings and SQEs
+// - get_sqe() / submit() / peek_cqe() / wait_cqe() / cqe_seen()
+// - register_buffers() for fixed-buffer I/O
+//
+// One submitting thread per ring (like IORING_SETUP_SINGLE_ISSUER).
+// Linux-only; needs <linux/io_uring.h> from the kernel headers.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace lat {
+
+class Uring {
+public:
+    Uring() = default;
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+    ~Uring() { close_ring(); }
+
+    // Returns 0 or -errno. sq_idle_ms: how long the SQPOLL thread spins
+    // before it sleeps and needs an explicit wakeup.
+    int init(unsigned entries, unsigned flags = 0, unsigned sq_idle_ms = 1000) {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        p.flags = flags;
+        p.sq_thread_idle = sq_idle_ms;
+        fd_ = (int)syscall(__NR_io_uring_setup, entries, &p);
+        if (fd_ < 0) return -errno;
+        flags_ = flags;
+
+        sq_sz_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_sz_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sq_sz_ = cq_sz_ = sq_sz_ > cq_sz_ ? sq_sz_ : cq_sz_;
+
+        sq_ptr_ = mmap(nullptr, sq_sz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == MAP_FAILED) return fail();
+        cq_ptr_ = single ? sq_ptr_
+                         : mmap(nullptr, cq_sz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                fd_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) return fail();
+        sqes_sz_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_sz_, PROT_READ | PROT_WRITE,
+                                                MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+        if (sqes_ == MAP_FAILED) return fail();
+
+        char* sq = static_cast<char*>(sq_ptr_);
+        sq_head_  = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail_  = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask_  = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_flags_ = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        sq_entries_ = p.sq_entries;
+
+        char* cq = static_cast<char*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_    = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        local_tail_ = *sq_tail_;
+        return 0;
+    }
+
+    bool sqpoll() const { return flags_ & IORING_SETUP_SQPOLL; }
+
+    // Zeroed SQE, or nullptr if the SQ ring is full.
+    io_uring_sqe* get_sqe() {
+        const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (local_tail_ - head >= sq_entries_) return nullptr;
+        const unsigned idx = local_tail_ & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array_[idx] = idx;
+        local_tail_++;
+        pending_++;
+        return sqe;
+    }
+
+    // Publishes queued SQEs. Without SQPOLL this is one io_uring_enter;
+    // with SQPOLL it is a store, plus a wakeup only if the thread slept.
+    int submit(unsigned wait_nr = 0) {
+        const unsigned n = pending_;
+        pending_ = 0;
+        __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+        if (sqpoll()) {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            unsigned f = 0;
+            if (__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) f |= IORING_ENTER_SQ_WAKEUP;
+            if (wait_nr) f |= IORING_ENTER_GETEVENTS;
+            if (!f) return (int)n;
+            return enter(0, wait_nr, f);
+        }
+        return enter(n, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+    }
+
+    io_uring_cqe* peek_cqe() {
+        const unsigned head = *cq_head_;
+        if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) return nullptr;
+        return &cqes_[head & cq_mask_];
+    }
+
+    // Blocks in the kernel until a completion is available.
+    io_uring_cqe* wait_cqe() {
+        for (;;) {
+            if (io_uring_cqe* c = peek_cqe()) return c;
+            if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return nullptr;
+        }
+    }
+
+    void cqe_seen() { __atomic_store_n(cq_head_, *cq_head_ + 1, __ATOMIC_RELEASE); }
+
+    int register_buffers(const iovec* iov, unsigned n) {
+        return (int)syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, iov, n) < 0 ? -errno : 0;
+    }
+
+    int ring_fd() const { return fd_; }
+
+private:
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return (int)syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags, nullptr, 0);
+    }
+
+    int fail() {
+        const int e = errno;
+        close_ring();
+        return -e;
+    }
+
+    void close_ring() {
+        if (sqes_ && sqes_ != MAP_FAILED) munmap(sqes_, sqes_sz_);
+        if (cq_ptr_ && cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_sz_);
+        if (sq_ptr_ && sq_ptr_ != MAP_FAILED) munmap(sq_ptr_, sq_sz_);
+        if (fd_ >= 0) close(fd_);
+        sqes_ = nullptr;
+        cq_ptr_ = sq_ptr_ = nullptr;
+        fd_ = -1;
+    }
+
+    int      fd_ = -1;
+    unsigned flags_ = 0;
+
+    void*  sq_ptr_ = nullptr;
+    void*  cq_ptr_ = nullptr;
+    size_t sq_sz_ = 0, cq_sz_ = 0, sqes_sz_ = 0;
+
+    unsigned*     sq_head_ = nullptr;
+    unsigned*     sq_tail_ = nullptr;
+    unsigned*     sq_flags_ = nullptr;
+    unsigned*     sq_array_ = nullptr;
+    unsigned      sq_mask_ = 0;
+    unsigned      sq_entries_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned      local_tail_ = 0;
+    unsigned      pending_ = 0;
+
+    unsigned*     cq_head_ = nullptr;
+    unsigned*     cq_tail_ = nullptr;
+    unsigned      cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+} // namespace lat
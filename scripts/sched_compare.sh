@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Same workload under each scheduling policy, with CPU hogs on the same CPU.
+# Usage: ./scripts/sched_compare.sh [mode] [hogs] [cpu]
+MODE="${1:-baseline}"
+HOGS="${2:-2}"
+CPU="${3:-0}"
+ITERS=300000
+
+OUT="results/sched_$(date +%Y%m%d_%H%M%S).txt"
+mkdir -p results
+echo "Building..."
+make -s
+
+POLICIES=(
+  "--sched=other --nice=0"
+  "--sched=other --nice=-10"
+  "--sched=other --nice=10"
+  "--sched=batch"
+  "--sched=idle"
+  "--sched=fifo --prio=50"
+  "--sched=rr --prio=50"
+)
+
+echo "Running $MODE with $HOGS hog(s) on CPU $CPU..."
+for p in "${POLICIES[@]}"; do
+  echo "---- $p ----" >> "$OUT"
+  # shellcheck disable=SC2086
+  ./latency "$MODE" $p --hogs="$HOGS" --cpu="$CPU" --iters="$ITERS" >> "$OUT" 2>&1 || echo "(failed)" >> "$OUT"
+  echo "" >> "$OUT"
+done
+
+# SCHED_DEADLINE refuses an affinity narrower than its root domain, so
+# this row is unpinned: one batch of hogs per CPU, all floating.
+NCPU=$(nproc)
+DL_HOGS=$((HOGS * NCPU))
+echo "---- --sched=deadline --dl=900/1000/1000 (unpinned, $DL_HOGS hogs over $NCPU CPUs) ----" >> "$OUT"
+./latency "$MODE" --sched=deadline --dl=900/1000/1000 --hogs="$DL_HOGS" --iters="$ITERS" >> "$OUT" 2>&1 || echo "(failed)" >> "$OUT"
+echo "" >> "$OUT"
+
+echo "Saved: $OUT"
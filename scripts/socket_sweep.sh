@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Loopback round-trip latency by socket type and message size.
+# Usage: ./scripts/socket_sweep.sh [peer: process|thread] [cpu]
+PEER="${1:-process}"
+CPU="${2:-0}"
+ITERS=50000
+
+OUT="results/socket_$(date +%Y%m%d_%H%M%S).txt"
+mkdir -p results
+echo "Building..."
+make -s
+
+SOCKS=(
+  "--sock=udp"
+  "--sock=tcp"
+  "--sock=tcp --busy-poll=50"
+  "--sock=unix-stream"
+  "--sock=unix-dgram"
+)
+SIZES=(64 512 4096 16384 65000)
+
+echo "Running socket round trips (peer: $PEER)..."
+printf "%-28s %7s %9s %9s %9s %10s\n" "socket" "size" "p50" "p99" "p99.9" "max" >> "$OUT"
+for s in "${SOCKS[@]}"; do
+  for size in "${SIZES[@]}"; do
+    # shellcheck disable=SC2086
+    res=$(./latency socket $s --size="$size" --peer="$PEER" --cpu="$CPU" --iters="$ITERS" 2>/dev/null || true)
+    p50=$(awk '/^p50:/ {print $2}' <<< "$res")
+    p99=$(awk '/^p99:/ {print $2}' <<< "$res")
+    p999=$(awk '/^p99.9:/ {print $2}' <<< "$res")
+    max=$(awk '/^max:/ {print $2}' <<< "$res")
+    printf "%-28s %7s %9s %9s %9s %10s\n" "$s" "$size" "${p50:--}" "${p99:--}" "${p999:--}" "${max:--}" >> "$OUT"
+  done
+done
+
+echo "Saved: $OUT"
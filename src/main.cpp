@@ -1,15 +1,39 @@
 #include <algorithm>
+#include <array>
+#include <cerrno>
 #include <chrono>
+#include <cstdio>
 #include <cstdint>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <numeric>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <fcntl.h>    // mmapfile mode: open(), posix_fallocate() / F_PREALLOCATE
+#include <sys/mman.h> // mmap(), msync()
 #include <unistd.h>   // getpid(), sysconf()
 
+#include <arpa/inet.h>    // socket mode: 127.0.0.1 ping-pong
+#include <netinet/in.h>
+#include <netinet/tcp.h>  // TCP_NODELAY
+#include <sys/socket.h>
+#include <sys/wait.h>     // waitpid(): hogs, socket echo peer
+
+#if defined(__linux__)
+#include <csignal>
+#include <sched.h>        // sched_setscheduler(), CPU_SET
+#include <sys/prctl.h>    // PR_SET_PDEATHSIG
+#include <sys/resource.h> // setpriority()
+#include <sys/syscall.h>  // SYS_sched_setattr (SCHED_DEADLINE)
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // _mm_clflushopt / _mm_clflush, _mm_mfence
+#endif
+
 // -----------------------------
 // Core idea of this program
 // -----------------------------
@@ -88,39 +112,656 @@ static void print_stats(const Stats& s) {
 // baseline: extremely tiny pure userspace work
 // syscall:  same, but forces kernel boundary each iteration
 // pagefault: forces first-touch of new pages inside the measured region
+// mmapfile: append one record to a MAP_SHARED file mapping: the file-backed
+//           pagefault case (page cache allocation, page_mkwrite, msync)
+// socket:   one round trip (send + receive the echo) to a peer over a
+//           local socket: the kernel networking stack on the hot path
 //
 // THEORY:
 // - syscall adds jitter because kernel entry/exit & scheduling effects
 // - pagefault adds huge spikes because the OS has to map a new page
 //   (fault handling, zero-fill, accounting, TLB updates, etc.)
+// - mmapfile faults like pagefault on every new page, plus the filesystem's
+//   page_mkwrite (block allocation unless preallocated) and, with msync,
+//   writeback on the hot path
+// - socket adds two syscalls, a protocol stack traversal each way and a
+//   wakeup of the peer: getpid() is its lower bound, not its model
 
-enum class Mode { Baseline, Syscall, Pagefault };
+enum class Mode { Baseline, Syscall, Pagefault, MmapFile, Socket };
 
 static Mode parse_mode(int argc, char** argv) {
-    if (argc < 2) return Mode::Baseline;
-    std::string m = argv[1];
+    // First argument that is not an --option.
+    std::string m;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--", 2) != 0) { m = argv[i]; break; }
+    }
+    if (m.empty()) return Mode::Baseline;
 
     if (m == "baseline") return Mode::Baseline;
     if (m == "syscall")  return Mode::Syscall;
     if (m == "pagefault") return Mode::Pagefault;
+    if (m == "mmapfile") return Mode::MmapFile;
+    if (m == "socket")   return Mode::Socket;
 
     // Default if user passes something unknown.
     return Mode::Baseline;
 }
 
+// -----------------------------
+// Options
+// -----------------------------
+// ./latency [mode] [--cold] [--cold-code] [--iters=N]
+//
+// --cold       before EACH measured iteration, flush the hot path's data
+//              (clflushopt) from every cache level. Outside the timed region.
+// --cold-code  --cold, plus run a large code footprint first to evict the
+//              I-cache, uop cache and branch predictor state.
+// --iters=N    measured iterations (default 1'000'000; 100'000 for socket).
+// --lazy-samples  keep samples in reserved-but-untouched memory (the old
+//              behaviour) instead of the prefaulted, locked sample store.
+// --capture=pair|stamp  pair (default): Clock::now() before and after each
+//              sample. stamp: ONE Clock::now() per sample; latencies are the
+//              differences of consecutive stamps, computed after the run.
+// --unroll=K   run the hot path K times per sample; report ns / K per op.
+//
+// mmapfile mode:
+// --dir=PATH         directory for the mapped file (default .)
+// --record=N         bytes per appended record (default 64)
+// --fallocate        preallocate the file instead of a sparse ftruncate
+// --populate         MAP_POPULATE the mapping
+// --msync=async|sync msync(MS_ASYNC / MS_SYNC) the new bytes every --msync-every records
+// --msync-every=N    default 64
+//
+// Socket mode:
+// --sock=T        udp | tcp | unix-stream | unix-dgram (default udp)
+// --size=N        message bytes per direction (default 64)
+// --peer=P        echo peer runs as a thread | process (default process)
+// --peer-cpu=N    pin the peer (default: --cpu + 1 when --cpu is given)
+// --busy-poll=US  SO_BUSY_POLL on both ends (udp / tcp; Linux, needs CAP_NET_ADMIN)
+//
+// Scheduling (Linux):
+// --cpu=N      pin the measured thread to CPU N.
+// --sched=P    policy: other | batch | idle | fifo | rr | deadline.
+// --nice=N     nice level for other / batch.
+// --prio=N     RT priority for fifo / rr (default 50).
+// --dl=R/D/P   SCHED_DEADLINE runtime / deadline / period in us (default 900/1000/1000).
+// --hogs=N     fork N CPU-burning processes onto the same CPU (default CPU 0).
+//              With --sched=deadline nothing is pinned (see apply_sched) and
+//              the hogs float over the whole root domain, like us.
+//
+// THEORY:
+// - the warm loop measures the best case: everything in L1, branches trained
+// - a real event (an order after a quiet period) arrives to a cold cache
+// - cold-path latency is a separate distribution, not an outlier of the warm one
+// - pair capture pays two timer reads per sample; stamp capture pays one,
+//   and each sample also contains the loop's bookkeeping (storing a stamp)
+// - --unroll=K reports batch averages: ops shorter than a timer read become
+//   measurable, but a spike inside a batch is divided by K
+
+struct Options {
+    Mode mode      = Mode::Baseline;
+    bool cold_data = false;
+    bool cold_code = false;
+    int  iters     = 1'000'000;
+    bool lazy_samples = false;
+    bool stamp_capture = false;
+    int  unroll    = 1;
+
+    int         cpu    = -1; // -1: not pinned
+    std::string sched;       // empty: leave the inherited policy alone
+    int         nice   = 0;
+    int         prio   = 50;
+    int         hogs   = 0;
+    uint64_t    dl_runtime_us  = 900;
+    uint64_t    dl_deadline_us = 1000;
+    uint64_t    dl_period_us   = 1000;
+
+    std::string dir          = ".";
+    size_t      record       = 64;
+    bool        fallocate    = false;
+    bool        populate     = false;
+    int         msync_flags  = 0; // 0: never msync
+    int         msync_every  = 64;
+
+    std::string sock      = "udp";
+    size_t      msg_size  = 64;
+    bool        peer_proc = true;
+    int         peer_cpu  = -1;
+    int         busy_poll_us = 0;
+};
+
+static Options parse_options(int argc, char** argv) {
+    Options o;
+    o.mode = parse_mode(argc, argv);
+    bool iters_set = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a == "--cold") o.cold_data = true;
+        else if (a == "--cold-code") o.cold_data = o.cold_code = true;
+        else if (a.rfind("--iters=", 0) == 0) { o.iters = std::max(1, std::stoi(a.substr(8))); iters_set = true; }
+        else if (a == "--lazy-samples") o.lazy_samples = true;
+        else if (a == "--capture=stamp") o.stamp_capture = true;
+        else if (a == "--capture=pair")  o.stamp_capture = false;
+        else if (a.rfind("--unroll=", 0) == 0) o.unroll = std::max(1, std::stoi(a.substr(9)));
+        else if (a.rfind("--cpu=", 0) == 0)   o.cpu = std::max(0, std::stoi(a.substr(6)));
+        else if (a.rfind("--sched=", 0) == 0) o.sched = a.substr(8);
+        else if (a.rfind("--nice=", 0) == 0)  o.nice = std::stoi(a.substr(7));
+        else if (a.rfind("--prio=", 0) == 0)  o.prio = std::stoi(a.substr(7));
+        else if (a.rfind("--hogs=", 0) == 0)  o.hogs = std::max(0, std::stoi(a.substr(7)));
+        else if (a.rfind("--dl=", 0) == 0) {
+            unsigned long long r = 0, d = 0, pr = 0;
+            if (std::sscanf(a.c_str() + 5, "%llu/%llu/%llu", &r, &d, &pr) == 3) {
+                o.dl_runtime_us = r;
+                o.dl_deadline_us = d;
+                o.dl_period_us = pr;
+            }
+        }
+        else if (a.rfind("--dir=", 0) == 0)       o.dir = a.substr(6);
+        else if (a.rfind("--record=", 0) == 0)    o.record = (size_t)std::max(1, std::stoi(a.substr(9)));
+        else if (a == "--fallocate")              o.fallocate = true;
+        else if (a == "--populate")               o.populate = true;
+        else if (a == "--msync=async")            o.msync_flags = MS_ASYNC;
+        else if (a == "--msync=sync")             o.msync_flags = MS_SYNC;
+        else if (a.rfind("--msync-every=", 0) == 0) o.msync_every = std::max(1, std::stoi(a.substr(14)));
+        else if (a.rfind("--sock=", 0) == 0)      o.sock = a.substr(7);
+        else if (a.rfind("--size=", 0) == 0)      o.msg_size = (size_t)std::max(1, std::stoi(a.substr(7)));
+        else if (a.rfind("--peer=", 0) == 0)      o.peer_proc = a.substr(7) != "thread";
+        else if (a.rfind("--peer-cpu=", 0) == 0)  o.peer_cpu = std::max(0, std::stoi(a.substr(11)));
+        else if (a.rfind("--busy-poll=", 0) == 0) o.busy_poll_us = std::max(0, std::stoi(a.substr(12)));
+    }
+    // A round trip is ~10 us, not ~10 ns: keep the default run short.
+    if (o.mode == Mode::Socket && !iters_set) o.iters = 100'000;
+    if (o.mode == Mode::Socket && o.peer_cpu < 0 && o.cpu >= 0) {
+        o.peer_cpu = (o.cpu + 1) % std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    }
+    // Datagrams must fit in one send (UDP payload limit).
+    if (o.sock == "udp" || o.sock == "unix-dgram") o.msg_size = std::min<size_t>(o.msg_size, 65'000);
+    // Hogs only compete if they share the measured thread's CPU.
+    // SCHED_DEADLINE cannot be pinned to a subset of its root domain.
+    if (o.sched == "deadline" && o.cpu >= 0) {
+        std::cerr << "NOTE: --cpu ignored with --sched=deadline (the kernel requires a DEADLINE task's"
+                  << " affinity to span its root domain; confine it with an exclusive cpuset instead)\n";
+        o.cpu = -1;
+    }
+    if (o.hogs > 0 && o.cpu < 0 && o.sched != "deadline") o.cpu = 0;
+    return o;
+}
+
+// -----------------------------
+// Scheduling setup (NOT measured)
+// -----------------------------
+// THEORY:
+// - SCHED_OTHER (CFS/EEVDF) shares a busy CPU by weight: nice matters,
+//   but every competitor still gets slices, so the tail has ms-sized gaps.
+// - SCHED_BATCH / SCHED_IDLE only make us yield MORE.
+// - SCHED_FIFO / SCHED_RR preempt all normal tasks: hogs only run when
+//   we block (RR also time-slices among equal RT priorities).
+// - SCHED_DEADLINE guarantees `runtime` every `period`, and THROTTLES us
+//   once it is used up: a busy loop sees a gap every period.
+// - RT throttling (sched_rt_runtime_us, 95% by default) still applies.
+
+#if defined(__linux__)
+
+// glibc has no wrapper for sched_setattr(); this is the kernel's layout.
+struct SchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t  sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+static bool pin_current(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+static std::vector<pid_t> spawn_hogs(int n, int cpu) {
+    std::vector<pid_t> pids;
+    for (int i = 0; i < n; i++) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL); // never outlive the benchmark
+            if (cpu >= 0) pin_current(cpu);
+            volatile uint64_t x = 0;
+            for (;;) x = x + 1;
+        }
+        if (pid > 0) pids.push_back(pid);
+    }
+    return pids;
+}
+
+static void stop_hogs(const std::vector<pid_t>& pids) {
+    for (pid_t p : pids) kill(p, SIGKILL);
+    for (pid_t p : pids) waitpid(p, nullptr, 0);
+}
+
+// Returns false (with a message) if the kernel refused.
+static bool apply_sched(const Options& o) {
+    if (o.cpu >= 0) {
+        if (!pin_current(o.cpu)) {
+            std::cerr << "sched_setaffinity(cpu " << o.cpu << "): " << std::strerror(errno) << "\n";
+            return false;
+        }
+    }
+    if (o.sched.empty()) return true;
+
+    int rc = 0;
+    sched_param sp{};
+    if (o.sched == "other" || o.sched == "batch" || o.sched == "idle") {
+        const int pol = o.sched == "other" ? SCHED_OTHER : o.sched == "batch" ? SCHED_BATCH : SCHED_IDLE;
+        rc = sched_setscheduler(0, pol, &sp);
+        if (rc == 0 && pol != SCHED_IDLE) rc = setpriority(PRIO_PROCESS, 0, o.nice);
+    } else if (o.sched == "fifo" || o.sched == "rr") {
+        sp.sched_priority = o.prio;
+        rc = sched_setscheduler(0, o.sched == "fifo" ? SCHED_FIFO : SCHED_RR, &sp);
+    } else if (o.sched == "deadline") {
+        SchedAttr attr{};
+        attr.size = sizeof(attr);
+        attr.sched_policy = SCHED_DEADLINE;
+        attr.sched_runtime  = o.dl_runtime_us * 1000;
+        attr.sched_deadline = o.dl_deadline_us * 1000;
+        attr.sched_period   = o.dl_period_us * 1000;
+        rc = (int)syscall(SYS_sched_setattr, 0, &attr, 0);
+    } else {
+        std::cerr << "unknown --sched=" << o.sched << "\n";
+        return false;
+    }
+    if (rc != 0) {
+        std::cerr << "setting --sched=" << o.sched << ": " << std::strerror(errno)
+                  << " (RT/deadline policies need root or CAP_SYS_NICE;"
+                  << " deadline also needs the task allowed on its whole root domain)\n";
+        return false;
+    }
+    return true;
+}
+
+#endif // __linux__
+
+// -----------------------------
+// Cold-cache helpers (NOT measured)
+// -----------------------------
+
+static inline void flush_line(const volatile void* p) {
+#if defined(__CLFLUSHOPT__)
+    _mm_clflushopt(const_cast<void*>(p));
+#elif defined(__x86_64__) || defined(__i386__)
+    _mm_clflush(const_cast<const void*>(p));
+#else
+    (void)p; // no user-space cache flush here; --cold only thrashes code
+#endif
+}
+
+static inline void flush_fence() {
+    // clflushopt is weakly ordered: fence so the flush completes before t0.
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_mfence();
+#endif
+}
+
+// Code-footprint thrash: THRASH_FNS distinct, branchy, non-inlined functions
+// (~64 B each => ~128 KB of code) called through a table.
+// Far larger than L1i / uop cache, and every call site + branch is a new
+// predictor entry, so the real hot path finds its code and branch history evicted.
+constexpr int THRASH_FNS = 2048;
+
+template <int N>
+__attribute__((noinline)) static uint64_t thrash_fn(uint64_t x) {
+    if (x & (1ull << (N % 61))) x = x * (uint64_t)(2 * N + 1) + (uint64_t)N;
+    else                        x ^= (uint64_t)N << (N % 17);
+    return x;
+}
+
+using ThrashFn = uint64_t (*)(uint64_t);
+
+template <int... Ns>
+static constexpr std::array<ThrashFn, sizeof...(Ns)> make_thrash_table(std::integer_sequence<int, Ns...>) {
+    return {&thrash_fn<Ns>...};
+}
+
+static const std::array<ThrashFn, THRASH_FNS> thrash_table =
+    make_thrash_table(std::make_integer_sequence<int, THRASH_FNS>{});
+
+static uint64_t thrash_code(uint64_t x) {
+    for (ThrashFn f : thrash_table) x = f(x);
+    return x;
+}
+
+// -----------------------------
+// Mapped append log (mmapfile mode, setup NOT measured)
+// -----------------------------
+// Binary loggers append into a mapped file: the hot path is a memcpy,
+// until it crosses into a page that is not mapped yet.
+//
+// THEORY:
+// - first store to a file page: page cache allocation (or read),
+//   then ->page_mkwrite, where ext4/xfs allocate blocks (delalloc
+//   reservation) unless the range was fallocate'd.
+// - MAP_POPULATE on a SHARED mapping only read-faults the pages: the
+//   first store still takes a write-protect fault (page_mkwrite).
+// - msync(MS_ASYNC) only starts writeback; MS_SYNC waits for the device.
+//   Both run on the hot path here, as they would in a naive logger.
+
+struct MappedLog {
+    char*  base = nullptr;
+    size_t bytes = 0;
+    int    fd = -1;
+    size_t synced = 0; // bytes already msync'ed
+
+    bool open_log(const Options& o, size_t records) {
+        const long page = sysconf(_SC_PAGESIZE);
+        bytes = (records * o.record + (size_t)page - 1) / (size_t)page * (size_t)page;
+        const std::string path = o.dir + "/lat_mmapfile.bin";
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) return false;
+        unlink(path.c_str()); // gone when we exit
+        if (o.fallocate) {
+#if defined(__linux__)
+            if (const int e = posix_fallocate(fd, 0, (off_t)bytes); e != 0) {
+                errno = e;
+                return false;
+            }
+#elif defined(__APPLE__)
+            // No posix_fallocate: reserve the blocks, then set the size.
+            fstore_t fs{F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)bytes, 0};
+            if (fcntl(fd, F_PREALLOCATE, &fs) != 0 || ftruncate(fd, (off_t)bytes) != 0) return false;
+#else
+            if (ftruncate(fd, (off_t)bytes) != 0) return false; // sparse: nothing to preallocate with
+#endif
+        } else if (ftruncate(fd, (off_t)bytes) != 0) {
+            return false;
+        }
+        const int flags = MAP_SHARED
+#if defined(MAP_POPULATE)
+                          | (o.populate ? MAP_POPULATE : 0)
+#endif
+            ;
+        void* m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+        if (m == MAP_FAILED) return false;
+        base = static_cast<char*>(m);
+        return true;
+    }
+
+    // msync needs a page-aligned start: round the synced offset down.
+    void sync_new(size_t end, int flags, size_t page) {
+        const size_t start = synced / page * page;
+        msync(base + start, end - start, flags);
+        synced = end;
+    }
+
+    ~MappedLog() {
+        if (base) munmap(base, bytes);
+        if (fd >= 0) close(fd);
+    }
+};
+
+// -----------------------------
+// Socket ping-pong (socket mode, setup NOT measured)
+// -----------------------------
+// An echo peer (thread or forked process) sends every message back.
+// One measured iteration = send `size` bytes + receive them again.
+//
+// THEORY:
+// - udp / tcp go through the full IP stack over the loopback device;
+//   tcp adds ACK / window processing and (without TCP_NODELAY) Nagle.
+// - unix sockets skip IP entirely: the lower bound for a local RTT.
+// - larger messages add copies (and segmentation for tcp).
+// - SO_BUSY_POLL spins in the driver's NAPI poll instead of sleeping;
+//   loopback has no NAPI context, so expect little change there.
+// - a process peer pays a full context switch per wakeup, a thread
+//   peer only the register state (same mm, no TLB flush).
+
+struct SockPair {
+    int  client = -1;
+    int  server = -1;
+    bool stream = false;
+};
+
+static bool open_sock_pair(const Options& o, SockPair& sp) {
+    if (o.sock == "unix-stream" || o.sock == "unix-dgram") {
+        sp.stream = o.sock == "unix-stream";
+        int fds[2];
+        if (socketpair(AF_UNIX, sp.stream ? SOCK_STREAM : SOCK_DGRAM, 0, fds) != 0) return false;
+        sp.client = fds[0];
+        sp.server = fds[1];
+        // Large dgrams need a send buffer bigger than the default.
+        const int buf = (int)std::max<size_t>(4 * o.msg_size, 1 << 16);
+        for (int fd : fds) setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+        return true;
+    }
+    if (o.sock != "udp" && o.sock != "tcp") {
+        std::cerr << "unknown --sock=" << o.sock << "\n";
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    sp.stream = o.sock == "tcp";
+
+    if (!sp.stream) {
+        sp.server = socket(AF_INET, SOCK_DGRAM, 0);
+        sp.client = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in caddr = addr;
+        if (bind(sp.server, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            bind(sp.client, (sockaddr*)&caddr, sizeof(caddr)) != 0) return false;
+        getsockname(sp.server, (sockaddr*)&addr, &len);
+        len = sizeof(caddr);
+        getsockname(sp.client, (sockaddr*)&caddr, &len);
+        if (connect(sp.client, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            connect(sp.server, (sockaddr*)&caddr, sizeof(caddr)) != 0) return false;
+    } else {
+        const int listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 1) != 0) {
+            close(listener);
+            return false;
+        }
+        getsockname(listener, (sockaddr*)&addr, &len);
+        sp.client = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(sp.client, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(listener);
+            return false;
+        }
+        sp.server = accept(listener, nullptr, nullptr);
+        close(listener);
+        const int one = 1;
+        setsockopt(sp.client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(sp.server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    if (o.busy_poll_us > 0) {
+#if defined(SO_BUSY_POLL)
+        for (int fd : {sp.client, sp.server}) {
+            if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &o.busy_poll_us, sizeof(o.busy_poll_us)) != 0) {
+                std::cerr << "SO_BUSY_POLL: " << std::strerror(errno) << "\n";
+                return false;
+            }
+        }
+#else
+        std::cerr << "SO_BUSY_POLL is not available here; ignored\n";
+#endif
+    }
+    return sp.server >= 0;
+}
+
+// Stream sockets may split a message; datagrams arrive whole.
+static bool send_msg(int fd, const char* p, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        const ssize_t r = send(fd, p + done, n - done, 0);
+        if (r <= 0) return false;
+        done += (size_t)r;
+    }
+    return true;
+}
+
+static bool recv_msg(int fd, char* p, size_t n, bool stream) {
+    if (!stream) return recv(fd, p, n, 0) > 0; // 0-byte datagram = stop
+    size_t done = 0;
+    while (done < n) {
+        const ssize_t r = recv(fd, p + done, n - done, 0);
+        if (r <= 0) return false;
+        done += (size_t)r;
+    }
+    return true;
+}
+
+static void echo_loop(int fd, size_t size, bool stream, int cpu) {
+#if defined(__linux__)
+    if (cpu >= 0) pin_current(cpu);
+#else
+    (void)cpu;
+#endif
+    std::vector<char> buf(size);
+    while (recv_msg(fd, buf.data(), size, stream) && send_msg(fd, buf.data(), size)) {}
+}
+
+struct EchoPeer {
+    SockPair    sp;
+    pid_t       pid = -1;
+    std::thread th;
+
+    bool start(const Options& o) {
+        if (!open_sock_pair(o, sp)) return false;
+        if (!o.peer_proc) {
+            th = std::thread(echo_loop, sp.server, o.msg_size, sp.stream, o.peer_cpu);
+            return true;
+        }
+        pid = fork();
+        if (pid == 0) {
+#if defined(__linux__)
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+            close(sp.client);
+            echo_loop(sp.server, o.msg_size, sp.stream, o.peer_cpu);
+            _exit(0);
+        }
+        return pid > 0;
+    }
+
+    void stop() {
+        if (sp.client < 0) return;
+        if (sp.stream) shutdown(sp.client, SHUT_RDWR);
+        else (void)send(sp.client, "", 0, 0);
+        if (th.joinable()) th.join();
+        if (pid > 0) waitpid(pid, nullptr, 0);
+        close(sp.client);
+        close(sp.server);
+        sp.client = sp.server = -1;
+    }
+};
+
+// -----------------------------
+// Sample store (setup NOT measured)
+// -----------------------------
+// One uint64_t per iteration: 8 MB for 1M iterations. A reserved
+// std::vector only reserves address space, so the first sample on every
+// new page page-faults BETWEEN measurements (~2000 faults per run): the
+// harness pollutes the caches and TLB around the iterations it times.
+//
+// The store below is set up before the loop instead:
+// - 2 MB pages: MAP_HUGETLB if the pool has pages, else MADV_HUGEPAGE (THP)
+// - every page written once (prefault)
+// - mlock'ed, so nothing is reclaimed or migrated during the run
+// --lazy-samples maps it the old way (untouched 4 KB pages) to compare.
+
+struct SampleStore {
+    uint64_t*   data = nullptr;
+    size_t      n = 0;
+    size_t      bytes = 0;
+    const char* pages = "4 KB"; // what backs it
+    bool        prefaulted = false;
+    bool        locked = false;
+
+    bool open(size_t count, bool lazy) {
+        const size_t huge = 2u << 20;
+        bytes = (count * sizeof(uint64_t) + huge - 1) / huge * huge;
+        void* m = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+        if (!lazy) {
+            m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (m != MAP_FAILED) pages = "2 MB hugetlb";
+        }
+#endif
+        if (m == MAP_FAILED) {
+            m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (m == MAP_FAILED) return false;
+#if defined(MADV_HUGEPAGE)
+            if (!lazy && madvise(m, bytes, MADV_HUGEPAGE) == 0) pages = "2 MB THP (madvise)";
+#endif
+#if defined(MADV_NOHUGEPAGE)
+            if (lazy) madvise(m, bytes, MADV_NOHUGEPAGE);
+#endif
+        }
+        data = static_cast<uint64_t*>(m);
+        if (lazy) return true;
+
+        std::memset(data, 0, bytes);
+        prefaulted = true;
+        locked = mlock(data, bytes) == 0;
+        return true;
+    }
+
+    void push(uint64_t v) { data[n++] = v; }
+
+    // Stamp capture: n timestamps -> n - 1 differences, each divided by k.
+    void to_deltas(size_t k) {
+        if (n == 0) return;
+        for (size_t i = 0; i + 1 < n; i++) data[i] = (data[i + 1] - data[i]) / k;
+        n--;
+    }
+
+    std::vector<uint64_t> to_vector() const { return std::vector<uint64_t>(data, data + n); }
+
+    ~SampleStore() {
+        if (data) munmap(data, bytes);
+    }
+};
+
 // -----------------------------
 // Main benchmark runner
 // -----------------------------
 
 int main(int argc, char** argv) {
-    const Mode mode = parse_mode(argc, argv);
+    const Options opt = parse_options(argc, argv);
+    const Mode mode = opt.mode;
 
     // Measurement settings
     // THEORY:
     // - warmup reduces first-time effects: instruction cache, branch predictor, etc.
     // - more iterations gives us a stable distribution to compute percentiles.
     const int WARMUP_ITERS = 50'000;
-    const int ITERS        = 1'000'000;
+    const int ITERS        = opt.iters;
+
+    if (opt.stamp_capture && opt.cold_data) {
+        std::cerr << "--cold needs --capture=pair: with stamps, the flush would be timed\n";
+        return 1;
+    }
+
+    // Competing processes first (they must NOT inherit our policy),
+    // then our own affinity / policy.
+#if defined(__linux__)
+    const std::vector<pid_t> hogs = spawn_hogs(opt.hogs, opt.cpu); // -1 (deadline): unpinned
+    if (!apply_sched(opt)) {
+        stop_hogs(hogs);
+        return 1;
+    }
+#else
+    if (opt.cpu >= 0 || !opt.sched.empty() || opt.hogs > 0) {
+        std::cerr << "--cpu / --sched / --hogs are Linux-only; ignored\n";
+    }
+#endif
 
     // volatile prevents compiler from optimizing away our "work".
     volatile uint64_t sink = 0;
@@ -146,13 +787,56 @@ int main(int argc, char** argv) {
         // Intentionally DO NOT memset / touch now.
     }
 
-    std::vector<uint64_t> samples;
-    samples.reserve(ITERS);
+    // Socket mode: connect an echo peer and warm up the path (NOT measured).
+    EchoPeer peer;
+    std::vector<char> msg;
+    if (mode == Mode::Socket) {
+        if (!peer.start(opt)) {
+            std::cerr << "socket setup (--sock=" << opt.sock << "): " << std::strerror(errno) << "\n";
+#if defined(__linux__)
+            stop_hogs(hogs);
+#endif
+            return 1;
+        }
+        msg.assign(opt.msg_size, 'x');
+        for (int i = 0; i < 1000; i++) {
+            send_msg(peer.sp.client, msg.data(), msg.size());
+            recv_msg(peer.sp.client, msg.data(), msg.size(), peer.sp.stream);
+        }
+    }
 
-    // Benchmark loop (MEASURED)
-    for (int i = 0; i < ITERS; i++) {
-        const auto t0 = Clock::now();
+    // mmapfile mode: create and map the log file, touch nothing yet.
+    MappedLog mlog;
+    std::vector<char> record;
+    if (mode == Mode::MmapFile) {
+        if (!mlog.open_log(opt, (size_t)ITERS * (size_t)opt.unroll)) {
+            std::cerr << "mmapfile setup (--dir=" << opt.dir << "): " << std::strerror(errno) << "\n";
+#if defined(__linux__)
+            stop_hogs(hogs);
+#endif
+            return 1;
+        }
+        record.assign(opt.record, 'r');
+    }
 
+    SampleStore samples;
+    if (!samples.open((size_t)ITERS + 1, opt.lazy_samples)) { // +1: stamp capture's opening stamp
+        std::cerr << "sample store: " << std::strerror(errno) << "\n";
+        peer.stop();
+#if defined(__linux__)
+        stop_hogs(hogs);
+#endif
+        return 1;
+    }
+
+#if defined(__linux__)
+    rusage ru0{};
+    getrusage(RUSAGE_SELF, &ru0);
+#endif
+
+    // One hot-path operation. j counts operations: ITERS * unroll of them.
+    // Inlined into the loop below; the lambda only avoids writing it twice.
+    auto hot_op = [&](size_t j) -> bool {
         // -----------------------------
         // HOT PATH work starts here
         // -----------------------------
@@ -161,34 +845,173 @@ int main(int argc, char** argv) {
 
         if (mode == Mode::Baseline) {
             // Tiny arithmetic; stays in user-space.
-            sink ^= (sink << 1) + 0x9e3779b97f4a7c15ull;
+            sink = sink ^ ((sink << 1) + 0x9e3779b97f4a7c15ull);
         }
         else if (mode == Mode::Syscall) {
             // Any syscall crosses user -> kernel -> user.
             // Even if "fast", it can introduce variability.
             (void)getpid();
-            sink ^= (sink << 1) + 0x9e3779b97f4a7c15ull;
+            sink = sink ^ ((sink << 1) + 0x9e3779b97f4a7c15ull);
+        }
+        else if (mode == Mode::MmapFile) {
+            // Append one record; every msync_every records, msync what is new.
+            const size_t off = j * opt.record;
+            std::memcpy(record.data(), (const void*)&sink, std::min(sizeof(uint64_t), opt.record));
+            std::memcpy(mlog.base + off, record.data(), opt.record);
+            if (opt.msync_flags && (j + 1) % (size_t)opt.msync_every == 0) {
+                mlog.sync_new(off + opt.record, opt.msync_flags, (size_t)page_size);
+            }
+            sink = sink ^ ((sink << 1) + (uint64_t)(unsigned char)mlog.base[off]);
+        }
+        else if (mode == Mode::Socket) {
+            // One round trip: our send, the peer's wakeup + echo, our receive.
+            msg[0] = (char)sink;
+            if (!send_msg(peer.sp.client, msg.data(), msg.size()) ||
+                !recv_msg(peer.sp.client, msg.data(), msg.size(), peer.sp.stream)) {
+                std::cerr << "socket round trip failed: " << std::strerror(errno) << "\n";
+                return false;
+            }
+            sink = sink ^ ((sink << 1) + (uint64_t)(unsigned char)msg[0]);
         }
-        else { 
+        else {
             // Mode::Pagefault
             // Force first-touch on a fresh page (write causes page fault on first use).
             // We cycle through pages; during early iterations many touches are "cold".
-            const size_t page = (size_t)i % PF_PAGES;
+            const size_t page = j % PF_PAGES;
             page_buf[page * (size_t)page_size]++; // first-touch => likely fault (initially)
-            sink ^= (sink << 1) + 0x9e3779b97f4a7c15ull;
+            sink = sink ^ ((sink << 1) + 0x9e3779b97f4a7c15ull);
         }
 
         // -----------------------------
         // "Hot path" work ends here
         // -----------------------------
+        return true;
+    };
 
+    const size_t K = (size_t)opt.unroll;
+    const auto stamp_ns = [](Clock::time_point t) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    };
+    if (opt.stamp_capture) samples.push(stamp_ns(Clock::now()));
+
+    // mmapfile: with MAP_POPULATE every page is mapped before the loop.
+#if defined(MAP_POPULATE)
+    const bool mmap_populated = opt.populate;
+#else
+    const bool mmap_populated = false;
+#endif
+
+    // Benchmark loop (MEASURED)
+    bool ok = true;
+    for (int i = 0; i < ITERS && ok; i++) {
+        const size_t j0 = (size_t)i * K;
+
+        if (opt.stamp_capture) {
+            // Timestamp-only: the previous stamp closed the last sample and
+            // opens this one; nothing may run between them but the hot path.
+            for (size_t k = 0; k < K && ok; k++) ok = hot_op(j0 + k);
+            const uint64_t stamp = stamp_ns(Clock::now());
+            if (ok) samples.push(stamp); // a failed op is not a sample
+            continue;
+        }
+
+        // Cold-cache preparation (NOT measured).
+        // Code thrash first: it touches data too, so flush afterwards.
+        if (opt.cold_code) {
+            sink = sink ^ thrash_code(sink);
+        }
+        if (opt.cold_data) {
+            flush_line(&sink);
+            const size_t mapped_end = mmap_populated ? mlog.bytes
+                                      : (j0 * opt.record + (size_t)page_size - 1) / (size_t)page_size * (size_t)page_size;
+            // Every op of the batch, or ops 2..K would run warm.
+            for (size_t k = 0; k < K; k++) {
+                if (mode == Mode::Pagefault) {
+                    flush_line(&page_buf[((j0 + k) % PF_PAGES) * (size_t)page_size]);
+                }
+                if (mode == Mode::MmapFile) {
+                    // CLFLUSH faults like a load: flushing a record on a page the
+                    // loop has not written yet would take its file-page fault here,
+                    // untimed. Only flush records on pages already mapped.
+                    const size_t off = (j0 + k) * opt.record;
+                    if (off < mapped_end) flush_line(mlog.base + off);
+                }
+            }
+            flush_fence();
+        }
+
+        const auto t0 = Clock::now();
+        for (size_t k = 0; k < K && ok; k++) ok = hot_op(j0 + k);
         const auto t1 = Clock::now();
+        if (!ok) break; // a failed op is not a sample
         const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
-        samples.push_back((uint64_t)ns);
+        samples.push((uint64_t)ns / K);
     }
 
+    // Timestamp-only: turn N+1 stamps into N per-operation latencies.
+    if (opt.stamp_capture) samples.to_deltas(K);
+
+#if defined(__linux__)
+    // Faults taken by the whole loop: the workload's own plus the harness's.
+    rusage ru1{};
+    getrusage(RUSAGE_SELF, &ru1);
+    const long loop_minflt = ru1.ru_minflt - ru0.ru_minflt;
+#endif
+
+    peer.stop();
+#if defined(__linux__)
+    stop_hogs(hogs);
+#endif
+
+    // hot_op() already said why; a partial distribution is not a result.
+    if (!ok) return 1;
+
     // Compute stats (OFF hot path)
-    const Stats s = compute_stats(samples);
+    const Stats s = compute_stats(samples.to_vector());
+    if (!opt.sched.empty() || opt.hogs > 0) {
+        std::cout << "Sched: " << (opt.sched.empty() ? "inherited" : opt.sched);
+        if (opt.sched == "other" || opt.sched == "batch") std::cout << " nice " << opt.nice;
+        if (opt.sched == "fifo" || opt.sched == "rr") std::cout << " prio " << opt.prio;
+        if (opt.sched == "deadline") {
+            std::cout << " " << opt.dl_runtime_us << "/" << opt.dl_deadline_us << "/" << opt.dl_period_us << " us";
+        }
+        if (opt.cpu >= 0) std::cout << ", cpu " << opt.cpu;
+        else std::cout << ", unpinned";
+        std::cout << ", " << opt.hogs << " hog(s)\n";
+    }
+    if (mode == Mode::MmapFile) {
+        std::cout << "File: " << opt.record << "B records appended to a mapped file in " << opt.dir
+                  << " (" << (opt.fallocate ? "fallocate" : "sparse")
+                  << (opt.populate ? ", MAP_POPULATE" : "");
+        if (opt.msync_flags) {
+            std::cout << ", msync(" << (opt.msync_flags == MS_SYNC ? "MS_SYNC" : "MS_ASYNC")
+                      << ") every " << opt.msync_every;
+        }
+        std::cout << ")\n";
+    }
+    if (mode == Mode::Socket) {
+        std::cout << "Socket: " << opt.sock << " " << opt.msg_size << "B round trip, peer "
+                  << (opt.peer_proc ? "process" : "thread");
+        if (opt.peer_cpu >= 0) std::cout << " on cpu " << opt.peer_cpu;
+        if (opt.busy_poll_us > 0) std::cout << ", SO_BUSY_POLL " << opt.busy_poll_us << " us";
+        std::cout << "\n";
+    }
+    std::cout << "Samples: " << (samples.bytes >> 20) << " MB on " << samples.pages
+              << (samples.prefaulted ? ", prefaulted" : ", lazily faulted (--lazy-samples)")
+              << (samples.prefaulted ? (samples.locked ? ", mlocked" : ", mlock failed") : "")
+#if defined(__linux__)
+              << "; " << loop_minflt << " minor faults in the loop"
+#endif
+              << "\n";
+    if (opt.stamp_capture || opt.unroll > 1) {
+        std::cout << "Capture: " << (opt.stamp_capture ? "one timestamp per sample (consecutive differences)"
+                                                       : "timestamp pair per sample")
+                  << ", " << opt.unroll << " op(s) per sample, ns per op\n";
+    }
+    if (opt.cold_data) {
+        std::cout << "Cold: data flushed" << (opt.cold_code ? " + code/branch thrash" : "")
+                  << " before each iteration (untimed)\n";
+    }
     print_stats(s);
 
     // Keep sink alive (prevents aggressive optimization)